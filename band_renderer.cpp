@@ -0,0 +1,118 @@
+#include "band_renderer.h"
+#include <algorithm>
+#include <stdexcept>
+#include "stats.h"
+
+BandedRenderer::BandedRenderer(int width, int height, int bandHeight)
+    : width_(width), height_(height), bandHeight_(bandHeight)
+{
+    if (width <= 0 || height <= 0 || bandHeight <= 0)
+    {
+        throw std::invalid_argument("Banded render dimensions must be positive");
+    }
+}
+
+void BandedRenderer::binEdges(const Model &model, const std::vector<int> &screenX, const std::vector<int> &screenY,
+                              std::vector<size_t> &offsets, std::vector<int> &indices) const
+{
+    const int bandCount = getBandCount();
+
+    // Band range covered by an edge, or an empty range if it misses the image entirely
+    auto bandRange = [&](const std::pair<int, int> &edge, int &firstBand, int &lastBand)
+    {
+        int minY = std::min(screenY[edge.first], screenY[edge.second]);
+        int maxY = std::max(screenY[edge.first], screenY[edge.second]);
+        firstBand = std::max(minY, 0) / bandHeight_;
+        lastBand = std::min(maxY, height_ - 1) / bandHeight_;
+        return minY < height_ && maxY >= 0;
+    };
+
+    // First pass counts edges per band, second pass scatters indices
+    offsets.assign(bandCount + 1, 0);
+    const auto &edges = model.getUniqueEdges();
+    for (const auto &edge : edges)
+    {
+        int firstBand, lastBand;
+        if (!bandRange(edge, firstBand, lastBand))
+        {
+            // No band draws this edge; count its pixels as clipped, as a full-frame line() would
+            const int length = std::max(std::abs(screenX[edge.second] - screenX[edge.first]),
+                                        std::abs(screenY[edge.second] - screenY[edge.first]));
+            STATS_ADD(PixelsClipped, length + 1);
+            continue;
+        }
+        for (int b = firstBand; b <= lastBand; b++)
+        {
+            offsets[b + 1]++;
+        }
+    }
+    for (int b = 0; b < bandCount; b++)
+    {
+        offsets[b + 1] += offsets[b];
+    }
+
+    indices.resize(offsets[bandCount]);
+    std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        int firstBand, lastBand;
+        if (!bandRange(edges[i], firstBand, lastBand))
+        {
+            continue;
+        }
+        for (int b = firstBand; b <= lastBand; b++)
+        {
+            indices[cursor[b]++] = static_cast<int>(i);
+        }
+    }
+}
+
+bool BandedRenderer::render(const Model &model, TGAColor color, const std::string &filename, bool rle,
+                            const View &view) const
+{
+    // Project every vertex once; bands reuse the screen positions
+    std::vector<int> screenX;
+    std::vector<int> screenY;
+    projectVertices(model, view, width_, height_, screenX, screenY);
+
+    std::vector<size_t> offsets;
+    std::vector<int> indices;
+    {
+        STATS_SCOPED_TIMER(Projection);
+        binEdges(model, screenX, screenY, offsets, indices);
+    }
+
+    TGAStreamWriter writer(filename, width_, height_, TGAImage::RGB, rle);
+    if (!writer.is_open())
+    {
+        return false;
+    }
+
+    // One strip framebuffer is reused for every band. Lines are clipped to the image, not
+    // just the band, so the last band's spare rows stay empty and stats count each line once
+    const Rect image = {0, 0, width_, height_};
+    TGAImage band(width_, std::min(bandHeight_, height_), TGAImage::RGB);
+    const auto &edges = model.getUniqueEdges();
+    for (int b = 0; b < getBandCount(); b++)
+    {
+        const int originY = b * bandHeight_;
+        const int rows = std::min(bandHeight_, height_ - originY);
+        {
+            STATS_SCOPED_TIMER(Rasterization);
+            band.clear();
+            for (size_t i = offsets[b]; i < offsets[b + 1]; i++)
+            {
+                const auto &edge = edges[indices[i]];
+                line(screenX[edge.first], screenY[edge.first],
+                     screenX[edge.second], screenY[edge.second],
+                     band, color, image, originY);
+            }
+        }
+
+        if (!writer.write_band(band, rows))
+        {
+            return false;
+        }
+    }
+    return writer.close();
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "model.h"
+#include "rasterizer.h"
+#include "tgaimage.h"
+
+/**
+ * @brief Renders a model's wireframe one horizontal strip at a time
+ *
+ * Full-frame rendering needs the whole framebuffer in memory, which rules out
+ * poster-scale output. The banded renderer instead:
+ * - Projects every vertex to screen space once
+ * - Bins each edge into the bands its rows overlap
+ * - Rasterizes one band at a time into a strip framebuffer
+ * - Streams each finished strip straight into the output TGA file
+ *
+ * Peak memory is one band plus the mesh and its bins, regardless of output size.
+ * Every band produces exactly the pixels a full-frame render would.
+ */
+class BandedRenderer
+{
+public:
+    /**
+     * @brief Construct a renderer for an output image of the given size
+     * @param width Output width in pixels
+     * @param height Output height in pixels
+     * @param bandHeight Number of rows rasterized and written per band
+     */
+    BandedRenderer(int width, int height, int bandHeight);
+
+    /**
+     * @brief Render the model's edges and stream the result to a TGA file
+     * @param model The model to draw
+     * @param color Color of the edges
+     * @param filename Output TGA path
+     * @param rle Whether to RLE-compress the output
+     * @param view Camera used for the projection
+     * @return true on success, false if the file could not be written
+     */
+    bool render(const Model &model, TGAColor color, const std::string &filename, bool rle = true,
+                const View &view = View()) const;
+
+    int getBandCount() const
+    {
+        return (height_ + bandHeight_ - 1) / bandHeight_;
+    }
+
+private:
+    int width_;
+    int height_;
+    int bandHeight_;
+
+    /**
+     * @brief Bucket edge indices by band in compressed (offsets + indices) form
+     *
+     * Edges of band b are indices[offsets[b] .. offsets[b + 1]).
+     */
+    void binEdges(const Model &model, const std::vector<int> &screenX, const std::vector<int> &screenY,
+                  std::vector<size_t> &offsets, std::vector<int> &indices) const;
+};
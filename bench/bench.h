@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Settings shared by every benchmark in a run
+ */
+struct BenchConfig
+{
+    int warmupRuns = 3;             // Untimed runs before sampling starts
+    int samples = 25;               // Number of timed samples per benchmark
+    double minSampleNs = 1e6;       // Each sample batches iterations until it lasts at least this long
+    std::string filter;             // Only run benchmarks whose name contains this substring
+};
+
+/**
+ * @brief Timing statistics for one benchmark, in nanoseconds per iteration
+ */
+struct BenchResult
+{
+    std::string name;
+    std::string unit;               // What one "item" is (edges, pixels, bytes...)
+    double itemsPerIteration = 0;   // Work done by one call of the benchmark body
+    int iterationsPerSample = 1;
+    std::vector<double> samplesNs;  // Sorted per-iteration times
+
+    double percentile(double p) const
+    {
+        // Nearest-rank percentile on the sorted samples
+        size_t rank = static_cast<size_t>(p / 100.0 * (samplesNs.size() - 1) + 0.5);
+        return samplesNs[std::min(rank, samplesNs.size() - 1)];
+    }
+
+    double mean() const
+    {
+        return std::accumulate(samplesNs.begin(), samplesNs.end(), 0.0) / samplesNs.size();
+    }
+};
+
+/**
+ * @brief Minimal self-contained benchmark harness
+ *
+ * Each benchmark body is:
+ * - Run a few times untimed to warm caches and calibrate the batch size
+ * - Batched so each sample lasts long enough for the clock to resolve it
+ * - Sampled repeatedly, reporting min/median/p90/p99/max per iteration
+ *
+ * Results are written as JSON so they can be diffed across releases.
+ */
+class BenchRunner
+{
+public:
+    explicit BenchRunner(BenchConfig config) : config_(std::move(config)) {}
+
+    /**
+     * @brief Time a benchmark body
+     * @param name Unique benchmark name, e.g. "line/diablo3_pose/2048"
+     * @param unit Name of one item of work
+     * @param itemsPerIteration Items processed by one call of body, used for throughput
+     * @param body The code under test; its return value is consumed so it cannot be optimized away
+     */
+    void run(const std::string &name, const std::string &unit, double itemsPerIteration,
+             const std::function<std::uint64_t()> &body)
+    {
+        if (!config_.filter.empty() && name.find(config_.filter) == std::string::npos)
+        {
+            return;
+        }
+
+        BenchResult result;
+        result.name = name;
+        result.unit = unit;
+        result.itemsPerIteration = itemsPerIteration;
+
+        // Warm up and use the slowest warm-up run to size the batches
+        double warmupNs = 0;
+        for (int i = 0; i < std::max(config_.warmupRuns, 1); i++)
+        {
+            warmupNs = std::max(warmupNs, timeBatch(body, 1));
+        }
+        if (warmupNs > 0 && warmupNs < config_.minSampleNs)
+        {
+            result.iterationsPerSample = static_cast<int>(config_.minSampleNs / warmupNs) + 1;
+        }
+
+        for (int s = 0; s < config_.samples; s++)
+        {
+            result.samplesNs.push_back(timeBatch(body, result.iterationsPerSample) / result.iterationsPerSample);
+        }
+        std::sort(result.samplesNs.begin(), result.samplesNs.end());
+
+        std::cerr << std::left << std::setw(50) << name << std::right << std::fixed << std::setprecision(3)
+                  << " median " << std::setw(12) << result.percentile(50) / 1e6 << " ms"
+                  << "   p90 " << std::setw(12) << result.percentile(90) / 1e6 << " ms" << std::endl;
+        results_.push_back(std::move(result));
+    }
+
+    /**
+     * @brief Write all results as a JSON document
+     */
+    void writeJson(std::ostream &out) const
+    {
+        out << std::setprecision(6) << std::fixed;
+        out << "{\n  \"config\": {\"warmup_runs\": " << config_.warmupRuns
+            << ", \"samples\": " << config_.samples
+            << ", \"min_sample_ns\": " << config_.minSampleNs << "},\n";
+        out << "  \"benchmarks\": [";
+        for (size_t i = 0; i < results_.size(); i++)
+        {
+            const BenchResult &r = results_[i];
+            const double medianNs = r.percentile(50);
+            out << (i ? "," : "") << "\n    {\"name\": \"" << r.name << "\""
+                << ", \"unit\": \"" << r.unit << "\""
+                << ", \"items_per_iteration\": " << r.itemsPerIteration
+                << ", \"iterations_per_sample\": " << r.iterationsPerSample
+                << ", \"samples\": " << r.samplesNs.size()
+                << ", \"min_ns\": " << r.samplesNs.front()
+                << ", \"median_ns\": " << medianNs
+                << ", \"p90_ns\": " << r.percentile(90)
+                << ", \"p99_ns\": " << r.percentile(99)
+                << ", \"max_ns\": " << r.samplesNs.back()
+                << ", \"mean_ns\": " << r.mean()
+                << ", \"items_per_second\": " << (medianNs > 0 ? r.itemsPerIteration * 1e9 / medianNs : 0.0)
+                << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    /**
+     * @brief Checksum of all benchmark return values, printed so the work stays observable
+     */
+    std::uint64_t sink() const
+    {
+        return sink_;
+    }
+
+private:
+    BenchConfig config_;
+    std::vector<BenchResult> results_;
+    std::uint64_t sink_ = 0;
+
+    double timeBatch(const std::function<std::uint64_t()> &body, int iterations)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            sink_ += body();
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count();
+    }
+};
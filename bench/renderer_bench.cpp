@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "band_renderer.h"
+#include "obj_loader.h"
+#include "rasterizer.h"
+#include "tgaimage.h"
+
+#ifndef RENDERER_ASSET_DIR
+#define RENDERER_ASSET_DIR "obj"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+constexpr TGAColor white = {{255, 255, 255, 255}};
+
+/**
+ * @brief Read-only stream buffer over bytes already in memory, so decoding is timed without disk I/O
+ */
+class MemoryBuffer : public std::streambuf
+{
+public:
+    explicit MemoryBuffer(const std::string &bytes)
+    {
+        char *begin = const_cast<char *>(bytes.data());
+        setg(begin, begin, begin + bytes.size());
+    }
+};
+
+/**
+ * @brief Output stream buffer that only counts bytes, so encoding is timed without disk I/O
+ */
+class CountingBuffer : public std::streambuf
+{
+public:
+    std::uint64_t count = 0;
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        count++;
+        return ch;
+    }
+
+    std::streamsize xsputn(const char *, std::streamsize n) override
+    {
+        count += n;
+        return n;
+    }
+};
+
+std::vector<fs::path> findFiles(const fs::path &root, const std::string &extension)
+{
+    std::vector<fs::path> files;
+    for (const auto &entry : fs::recursive_directory_iterator(root))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == extension)
+        {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::string readBytes(const fs::path &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream bytes;
+    bytes << in.rdbuf();
+    return bytes.str();
+}
+
+void benchLoader(BenchRunner &runner, const fs::path &assets)
+{
+    for (const fs::path &path : findFiles(assets, ".obj"))
+    {
+        const std::string name = "obj_load/" + path.stem().string();
+        runner.run(name, "bytes", static_cast<double>(fs::file_size(path)), [&]()
+                   {
+                       Model model = OBJLoader::loadFromFile(path.string());
+                       return static_cast<std::uint64_t>(model.getEdgeCount()); });
+    }
+}
+
+void benchRasterizers(BenchRunner &runner, const fs::path &assets)
+{
+    const Model model = OBJLoader::loadFromFile((assets / "diablo3_pose" / "diablo3_pose.obj").string());
+
+    for (int size : {512, 2048, 8192})
+    {
+        // Project once: this times rasterization, not the viewport transform
+        std::vector<int> screen(model.getVertexCount() * 2);
+        std::vector<float> positions(model.getVertexCount() * 2);
+        for (size_t i = 0; i < model.getVertexCount(); i++)
+        {
+            const vec3 &v = model.getVertex(static_cast<int>(i));
+            screen[2 * i] = toScreen(v.x, size);
+            screen[2 * i + 1] = toScreen(v.y, size);
+            positions[2 * i] = toScreenPosition(v.x, 0.0f, 1.0f, size);
+            positions[2 * i + 1] = toScreenPosition(v.y, 0.0f, 1.0f, size);
+        }
+
+        TGAImage framebuffer(size, size, TGAImage::RGB);
+        runner.run("line/diablo3_pose/" + std::to_string(size), "edges",
+                   static_cast<double>(model.getUniqueEdges().size()), [&]()
+                   {
+                       for (const auto &edge : model.getUniqueEdges())
+                       {
+                           line(screen[2 * edge.first], screen[2 * edge.first + 1],
+                                screen[2 * edge.second], screen[2 * edge.second + 1], framebuffer, white);
+                       }
+                       return static_cast<std::uint64_t>(framebuffer.get(size / 2, size / 2).bgra[0]); });
+
+        // Same edges with coverage blending, to compare against supersampling the line above
+        runner.run("line_aa/diablo3_pose/" + std::to_string(size), "edges",
+                   static_cast<double>(model.getUniqueEdges().size()), [&]()
+                   {
+                       for (const auto &edge : model.getUniqueEdges())
+                       {
+                           lineAA(positions[2 * edge.first], positions[2 * edge.first + 1],
+                                  positions[2 * edge.second], positions[2 * edge.second + 1], framebuffer, white);
+                       }
+                       return static_cast<std::uint64_t>(framebuffer.get(size / 2, size / 2).bgra[0]); });
+    }
+
+    const fs::path output = fs::temp_directory_path() / "renderer_bench_banded.tga";
+    for (int size : {2048, 8192})
+    {
+        BandedRenderer renderer(size, size, 256);
+        runner.run("banded/diablo3_pose/" + std::to_string(size), "pixels",
+                   static_cast<double>(size) * size, [&]()
+                   { return static_cast<std::uint64_t>(renderer.render(model, white, output.string())); });
+    }
+    fs::remove(output);
+}
+
+void benchImageIO(BenchRunner &runner, const fs::path &assets)
+{
+    for (const fs::path &path : findFiles(assets, ".tga"))
+    {
+        const std::string bytes = readBytes(path);
+        TGAImage image;
+        MemoryBuffer probe(bytes);
+        std::istream probeStream(&probe);
+        if (!image.read_tga(probeStream))
+        {
+            continue;
+        }
+        const double pixels = static_cast<double>(image.width()) * image.height();
+        const std::string stem = path.stem().string();
+
+        runner.run("tga_decode/" + stem, "pixels", pixels, [&]()
+                   {
+                       MemoryBuffer buffer(bytes);
+                       std::istream in(&buffer);
+                       TGAImage decoded;
+                       return static_cast<std::uint64_t>(decoded.read_tga(in)); });
+
+        runner.run("tga_encode_rle/" + stem, "pixels", pixels, [&]()
+                   {
+                       CountingBuffer buffer;
+                       std::ostream out(&buffer);
+                       image.write_tga(out, true, true);
+                       return buffer.count; });
+    }
+}
+} // namespace
+
+/**
+ * @brief Benchmark the loader, rasterizers and TGA codec on the bundled assets
+ *
+ * Usage: renderer_bench [--assets DIR] [--filter SUBSTRING] [--samples N] [--warmup N] [--json FILE]
+ *
+ * Progress is printed to stderr; the JSON report goes to stdout unless --json is given.
+ */
+int main(int argc, char **argv)
+{
+    BenchConfig config;
+    fs::path assets = RENDERER_ASSET_DIR;
+    std::string jsonPath;
+
+    const char *const usage =
+        "Usage: renderer_bench [--assets DIR] [--filter SUBSTRING] [--samples N] [--warmup N] [--json FILE]";
+    for (int i = 1; i < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg != "--assets" && arg != "--filter" && arg != "--samples" && arg != "--warmup" && arg != "--json")
+        {
+            std::cerr << "Unknown option: " << arg << "\n" << usage << std::endl;
+            return 1;
+        }
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << arg << "\n" << usage << std::endl;
+            return 1;
+        }
+        std::string value = argv[i + 1];
+        try
+        {
+            if (arg == "--assets")
+                assets = value;
+            else if (arg == "--filter")
+                config.filter = value;
+            else if (arg == "--samples")
+                config.samples = std::max(1, std::stoi(value));
+            else if (arg == "--warmup")
+                config.warmupRuns = std::max(0, std::stoi(value));
+            else
+                jsonPath = value;
+        }
+        catch (const std::exception &)
+        {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            return 1;
+        }
+    }
+
+    try
+    {
+        BenchRunner runner(config);
+        benchLoader(runner, assets);
+        benchRasterizers(runner, assets);
+        benchImageIO(runner, assets);
+
+        if (jsonPath.empty())
+        {
+            runner.writeJson(std::cout);
+        }
+        else
+        {
+            std::ofstream out(jsonPath);
+            runner.writeJson(out);
+        }
+        std::cerr << "checksum " << runner.sink() << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
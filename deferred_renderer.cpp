@@ -0,0 +1,382 @@
+#include "deferred_renderer.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "stats.h"
+
+namespace
+{
+/**
+ * @brief Nearest-texel lookup with texture coordinates clamped to the image
+ *
+ * Textures are stored top row first after loading, while v grows upwards.
+ */
+TGAColor sample(const TGAImage &texture, const vec3 &uv)
+{
+    const int x = std::clamp(static_cast<int>(uv.x * texture.width()), 0, texture.width() - 1);
+    const int y = std::clamp(static_cast<int>((1.0f - uv.y) * texture.height()), 0, texture.height() - 1);
+    return texture.get(x, y);
+}
+
+/**
+ * @brief Twice the signed area of triangle (a, b, p); positive when p is left of a->b
+ */
+float edgeFunction(float ax, float ay, float bx, float by, float px, float py)
+{
+    return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
+
+// Rotated-grid sample positions relative to the pixel center: four samples, each on a
+// distinct row and column, resolve near-horizontal and near-vertical edges in 4 steps
+constexpr int SampleCount = 4;
+constexpr float SampleOffsetX[SampleCount] = {-0.125f, 0.375f, -0.375f, 0.125f};
+constexpr float SampleOffsetY[SampleCount] = {-0.375f, -0.125f, 0.125f, 0.375f};
+constexpr std::uint8_t FullCoverage = (1u << SampleCount) - 1;
+} // namespace
+
+std::string texturePath(const std::string &modelPath, const std::string &suffix)
+{
+    const size_t dot = modelPath.find_last_of('.');
+    const size_t slash = modelPath.find_last_of("/\\");
+    const bool hasExtension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    return (hasExtension ? modelPath.substr(0, dot) : modelPath) + suffix + ".tga";
+}
+
+DeferredRenderer::DeferredRenderer(int width, int height)
+    : width_(width), height_(height)
+{
+    if (width <= 0 || height <= 0)
+    {
+        throw std::invalid_argument("Deferred render dimensions must be positive");
+    }
+    const size_t pixels = static_cast<size_t>(width) * height;
+    triangle_.resize(pixels);
+    bary1_.resize(pixels);
+    bary2_.resize(pixels);
+    depth_.resize(pixels);
+}
+
+void DeferredRenderer::rasterize(const Model &model, const View &view, bool antialias)
+{
+    std::fill(triangle_.begin(), triangle_.end(), NoTriangle);
+    std::fill(depth_.begin(), depth_.end(), -std::numeric_limits<float>::infinity());
+    antialias_ = antialias;
+    if (antialias)
+    {
+        coverage_.assign(triangle_.size(), 0);
+    }
+
+    // Sub-pixel screen positions; the visibility pass needs more precision than the
+    // integer positions used for lines
+    auto toScreenX = [&](float x)
+    { return toScreenPosition(x, view.centerX, view.zoom, width_); };
+    auto toScreenY = [&](float y)
+    { return toScreenPosition(y, view.centerY, view.zoom, height_); };
+
+    std::uint64_t fragments = 0;
+    float x[3], y[3], z[3];
+
+    if (model.getMeshletCount() == 0)
+    {
+        // Models built without meshlets are projected and rasterized face by face
+        std::vector<vec3> screen(model.getVertexCount());
+        {
+            STATS_SCOPED_TIMER(Projection);
+            for (size_t i = 0; i < screen.size(); i++)
+            {
+                const vec3 &v = model.getVertex(static_cast<int>(i));
+                screen[i] = vec3(toScreenX(v.x), toScreenY(v.y), v.z);
+            }
+        }
+
+        STATS_SCOPED_TIMER(Rasterization);
+        for (size_t f = 0; f < model.getFaceCount(); f++)
+        {
+            const Face &face = model.getFace(static_cast<int>(f));
+            for (int k = 0; k < 3; k++)
+            {
+                x[k] = screen[face.vertex[k]].x;
+                y[k] = screen[face.vertex[k]].y;
+                z[k] = screen[face.vertex[k]].z;
+            }
+            fragments += rasterizeTriangle(static_cast<std::uint32_t>(f), x, y, z);
+        }
+        STATS_ADD(FragmentsTested, fragments);
+        return;
+    }
+
+    // Reject whole clusters first; only the survivors project their vertices
+    // and touch their triangles
+    std::vector<const Meshlet *> visible;
+    std::vector<vec3> screen;
+    std::vector<size_t> firstVertex;
+    {
+        STATS_SCOPED_TIMER(Projection);
+        for (size_t i = 0; i < model.getMeshletCount(); i++)
+        {
+            const Meshlet &meshlet = model.getMeshlet(static_cast<int>(i));
+            if (!isClusterVisible(meshlet, view))
+            {
+                STATS_ADD(MeshletsCulled, 1);
+                continue;
+            }
+            STATS_ADD(MeshletsDrawn, 1);
+            visible.push_back(&meshlet);
+            firstVertex.push_back(screen.size());
+            for (unsigned v = 0; v < meshlet.vertexCount; v++)
+            {
+                const vec3 &p = model.getVertex(model.getMeshletVertex(meshlet, v));
+                screen.push_back(vec3(toScreenX(p.x), toScreenY(p.y), p.z));
+            }
+        }
+    }
+
+    STATS_SCOPED_TIMER(Rasterization);
+    for (size_t i = 0; i < visible.size(); i++)
+    {
+        const Meshlet &meshlet = *visible[i];
+        const vec3 *local = screen.data() + firstVertex[i];
+        for (unsigned t = 0; t < meshlet.triangleCount; t++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                const vec3 &p = local[model.getMeshletCorner(meshlet, t, k)];
+                x[k] = p.x;
+                y[k] = p.y;
+                z[k] = p.z;
+            }
+            fragments += rasterizeTriangle(static_cast<std::uint32_t>(model.getMeshletFace(meshlet, t)), x, y, z);
+        }
+    }
+    STATS_ADD(FragmentsTested, fragments);
+}
+
+bool DeferredRenderer::isClusterVisible(const Meshlet &meshlet, const View &view) const
+{
+    // Off-screen: the projected bounding sphere misses the viewport
+    if (!isMeshletOnScreen(meshlet, view, width_, height_))
+    {
+        return false;
+    }
+
+    // Back-facing: the camera looks down -z, so a face is visible only if its normal has
+    // z > 0. Every normal lies within acos(coneCutoff) of the axis, so all of them point
+    // away once the axis is at least 90 degrees plus that half-angle from +z.
+    if (meshlet.coneCutoff >= 0.0f &&
+        meshlet.coneAxis.z <= -std::sqrt(1.0f - meshlet.coneCutoff * meshlet.coneCutoff))
+    {
+        return false;
+    }
+    return true;
+}
+
+std::uint64_t DeferredRenderer::rasterizeTriangle(std::uint32_t face, const float x[3], const float y[3], const float z[3])
+{
+    const float ax = x[0], ay = y[0];
+    const float bx = x[1], by = y[1];
+    const float cx = x[2], cy = y[2];
+
+    // Counter-clockwise triangles face the camera; the rest can never be visible
+    const float area = edgeFunction(ax, ay, bx, by, cx, cy);
+    if (area <= 0.0f)
+    {
+        return 0;
+    }
+
+    // Clamp in float first: a deep zoom puts vertices far outside the range of int
+    auto clampX = [&](float v)
+    { return std::clamp(v, -1.0f, static_cast<float>(width_)); };
+    auto clampY = [&](float v)
+    { return std::clamp(v, -1.0f, static_cast<float>(height_)); };
+    const int minX = std::max(0, static_cast<int>(std::floor(clampX(std::min({ax, bx, cx})))));
+    const int maxX = std::min(width_ - 1, static_cast<int>(std::ceil(clampX(std::max({ax, bx, cx})))));
+    const int minY = std::max(0, static_cast<int>(std::floor(clampY(std::min({ay, by, cy})))));
+    const int maxY = std::min(height_ - 1, static_cast<int>(std::ceil(clampY(std::max({ay, by, cy})))));
+    const float invArea = 1.0f / area;
+
+    // Change of each edge function per pixel step in x and y, used to move from the
+    // pixel center to the coverage samples
+    const float stepX[3] = {by - cy, cy - ay, ay - by};
+    const float stepY[3] = {cx - bx, ax - cx, bx - ax};
+    // Farthest any sample's edge value can be from the center's; pixels further than
+    // this inside or outside every edge need no per-sample tests
+    float margin[3];
+    for (int e = 0; e < 3; e++)
+    {
+        margin[e] = 0.375f * (std::abs(stepX[e]) + std::abs(stepY[e]));
+    }
+
+    std::uint64_t fragments = 0;
+    for (int py = minY; py <= maxY; py++)
+    {
+        const float sy = py + 0.5f;
+        for (int px = minX; px <= maxX; px++)
+        {
+            // Sample at the pixel center
+            const float sx = px + 0.5f;
+            float w0 = edgeFunction(bx, by, cx, cy, sx, sy);
+            float w1 = edgeFunction(cx, cy, ax, ay, sx, sy);
+            float w2 = edgeFunction(ax, ay, bx, by, sx, sy);
+            const size_t pixel = static_cast<size_t>(py) * width_ + px;
+            if (antialias_)
+            {
+                if (w0 < -margin[0] || w1 < -margin[1] || w2 < -margin[2])
+                {
+                    continue;
+                }
+                std::uint8_t mask = FullCoverage;
+                if (w0 < margin[0] || w1 < margin[1] || w2 < margin[2])
+                {
+                    // Near an edge: test each sample
+                    mask = 0;
+                    for (int s = 0; s < SampleCount; s++)
+                    {
+                        const float ox = SampleOffsetX[s], oy = SampleOffsetY[s];
+                        if (w0 + stepX[0] * ox + stepY[0] * oy >= 0.0f &&
+                            w1 + stepX[1] * ox + stepY[1] * oy >= 0.0f &&
+                            w2 + stepX[2] * ox + stepY[2] * oy >= 0.0f)
+                        {
+                            mask |= static_cast<std::uint8_t>(1u << s);
+                        }
+                    }
+                }
+                if (mask == 0)
+                {
+                    continue;
+                }
+                coverage_[pixel] |= mask;
+
+                // The center of a partly covered pixel may lie outside the triangle; use the
+                // centroid of the covered samples instead, which is always inside, so shade()
+                // never extrapolates attributes past the triangle
+                if (mask != FullCoverage)
+                {
+                    float ox = 0.0f, oy = 0.0f;
+                    for (int s = 0; s < SampleCount; s++)
+                    {
+                        if (mask & (1u << s))
+                        {
+                            ox += SampleOffsetX[s];
+                            oy += SampleOffsetY[s];
+                        }
+                    }
+                    const float count = static_cast<float>(std::popcount(mask));
+                    ox /= count;
+                    oy /= count;
+                    w0 += stepX[0] * ox + stepY[0] * oy;
+                    w1 += stepX[1] * ox + stepY[1] * oy;
+                    w2 += stepX[2] * ox + stepY[2] * oy;
+                }
+            }
+            else if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+            {
+                continue;
+            }
+
+            const float l1 = w1 * invArea;
+            const float l2 = w2 * invArea;
+            const float depth = z[0] + (z[1] - z[0]) * l1 + (z[2] - z[0]) * l2;
+            fragments++;
+            if (depth > depth_[pixel])
+            {
+                depth_[pixel] = depth;
+                triangle_[pixel] = face;
+                bary1_[pixel] = l1;
+                bary2_[pixel] = l2;
+            }
+        }
+    }
+    return fragments;
+}
+
+void DeferredRenderer::shade(const Model &model, const Material &material, const vec3 &lightDirection,
+                             TGAImage &framebuffer) const
+{
+    STATS_SCOPED_TIMER(Shading);
+    const vec3 light = lightDirection.normalize();
+    std::uint64_t shaded = 0;
+
+    for (int y = 0; y < height_; y++)
+    {
+        for (int x = 0; x < width_; x++)
+        {
+            const size_t pixel = static_cast<size_t>(y) * width_ + x;
+            if (triangle_[pixel] == NoTriangle)
+            {
+                continue;
+            }
+            const Face &face = model.getFace(static_cast<int>(triangle_[pixel]));
+            const float l1 = bary1_[pixel];
+            const float l2 = bary2_[pixel];
+            const float l0 = 1.0f - l1 - l2;
+
+            // Interpolate the attributes of the visible surface
+            vec3 uv;
+            if (face.hasUVs())
+            {
+                uv = model.getUV(face.uv[0]) * l0 + model.getUV(face.uv[1]) * l1 + model.getUV(face.uv[2]) * l2;
+            }
+            vec3 normal;
+            if (face.hasNormals())
+            {
+                normal = model.getNormal(face.normal[0]) * l0 + model.getNormal(face.normal[1]) * l1 +
+                         model.getNormal(face.normal[2]) * l2;
+            }
+            else
+            {
+                const vec3 &p0 = model.getVertex(face.vertex[0]);
+                normal = (model.getVertex(face.vertex[1]) - p0).cross(model.getVertex(face.vertex[2]) - p0);
+            }
+            normal = normal.normalize();
+
+            // Perturb the normal by the tangent-space normal map
+            if (material.normal && model.hasTangents() && face.hasUVs())
+            {
+                vec3 tangent = model.getTangent(face.vertex[0]) * l0 + model.getTangent(face.vertex[1]) * l1 +
+                               model.getTangent(face.vertex[2]) * l2;
+                tangent = (tangent - normal * normal.dot(tangent)).normalize();
+                const vec3 bitangent = normal.cross(tangent) * model.getBitangentSign(face.vertex[0]);
+
+                TGAColor texel = sample(*material.normal, uv);
+                const vec3 mapped(texel[2] / 127.5f - 1.0f, texel[1] / 127.5f - 1.0f, texel[0] / 127.5f - 1.0f);
+                normal = (tangent * mapped.x + bitangent * mapped.y + normal * mapped.z).normalize();
+            }
+
+            // Phong lighting with the camera looking down -z
+            const float diffuse = std::max(0.0f, normal.dot(light));
+            float specular = 0.0f;
+            if (material.specular)
+            {
+                const vec3 reflected = normal * (2.0f * normal.dot(light)) - light;
+                TGAColor texel = sample(*material.specular, uv);
+                specular = std::pow(std::max(reflected.z, 0.0f), 5.0f + texel[0]);
+            }
+
+            TGAColor color = material.diffuse ? sample(*material.diffuse, uv) : TGAColor{{255, 255, 255, 255}};
+            for (int c = 0; c < 3; c++)
+            {
+                color[c] = static_cast<std::uint8_t>(std::min(255.0f, 20.0f + color[c] * (diffuse + 0.6f * specular)));
+            }
+            // Resolve: edge pixels only partly hide what is behind them
+            if (antialias_ && coverage_[pixel] != FullCoverage)
+            {
+                blendPixel(framebuffer, x, y, color, std::popcount(coverage_[pixel]) / static_cast<float>(SampleCount));
+            }
+            else
+            {
+                framebuffer.set(x, y, color);
+            }
+            shaded++;
+        }
+    }
+    STATS_ADD(PixelsShaded, shaded);
+}
+
+size_t DeferredRenderer::getCoveredPixelCount() const
+{
+    return static_cast<size_t>(std::count_if(triangle_.begin(), triangle_.end(),
+                                             [](std::uint32_t id)
+                                             { return id != NoTriangle; }));
+}
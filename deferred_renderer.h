@@ -0,0 +1,136 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "geometry.h"
+#include "model.h"
+#include "rasterizer.h"
+#include "tgaimage.h"
+
+/**
+ * @brief Textures used to shade a model
+ *
+ * Any map may be null: a missing diffuse map shades white, a missing normal map keeps
+ * the interpolated vertex normal and a missing specular map disables highlights.
+ */
+struct Material
+{
+    std::shared_ptr<const TGAImage> diffuse;  // Base color (*_diffuse.tga)
+    std::shared_ptr<const TGAImage> normal;   // Tangent-space normal map (*_nm_tangent.tga)
+    std::shared_ptr<const TGAImage> specular; // Specular exponent map (*_spec.tga)
+};
+
+/**
+ * @brief Path of a texture that follows the bundled naming scheme
+ *
+ * For "obj/head/head.obj" and suffix "_diffuse" this is "obj/head/head_diffuse.tga".
+ */
+std::string texturePath(const std::string &modelPath, const std::string &suffix);
+
+/**
+ * @brief Renders shaded triangles with a visibility buffer
+ *
+ * Shading during rasterization wastes texture fetches and lighting on pixels that are
+ * later overdrawn. Instead, rendering happens in two passes:
+ * - rasterize() depth-tests every triangle and stores only the nearest triangle ID and
+ *   its barycentric coordinates per pixel
+ * - shade() then samples diffuse, normal and specular maps exactly once per visible pixel
+ *
+ * Shading cost therefore depends on the number of covered pixels, not on depth complexity.
+ *
+ * With antialiasing, rasterize() also records a 4-sample coverage mask per pixel (one
+ * byte instead of a 4x larger visibility buffer). Each pixel is still shaded once, and the
+ * resolve in shade() blends that color over the background by the fraction of samples
+ * covered, which smooths silhouettes like 4x supersampling at the cost of a single pass.
+ */
+class DeferredRenderer
+{
+public:
+    /**
+     * @brief Construct a renderer and its visibility buffer
+     * @param width Image width in pixels
+     * @param height Image height in pixels
+     */
+    DeferredRenderer(int width, int height);
+
+    /**
+     * @brief Visibility pass: record the nearest front-facing triangle at every pixel
+     *
+     * When the model has meshlets, clusters whose bounding sphere is off-screen or whose
+     * normal cone faces away from the camera are rejected before any of their vertices
+     * are projected or triangles set up.
+     *
+     * @param model The model to rasterize; its faces are used, edges are ignored
+     * @param view Camera used for the orthographic projection
+     * @param antialias Record sample coverage so shade() can smooth triangle edges
+     */
+    void rasterize(const Model &model, const View &view, bool antialias = false);
+
+    /**
+     * @brief Shading pass: light every pixel recorded by rasterize()
+     * @param model The model passed to rasterize()
+     * @param material Textures sampled once per visible pixel
+     * @param lightDirection Direction towards the light, in model space
+     * @param framebuffer Receives the shaded image; pixels with no triangle are left untouched
+     *                    and partially covered pixels are blended over their current color
+     */
+    void shade(const Model &model, const Material &material, const vec3 &lightDirection, TGAImage &framebuffer) const;
+
+    int getWidth() const
+    {
+        return width_;
+    }
+
+    int getHeight() const
+    {
+        return height_;
+    }
+
+    /**
+     * @brief Number of pixels covered by a triangle after the last rasterize()
+     */
+    size_t getCoveredPixelCount() const;
+
+    /**
+     * @brief Bytes of visibility buffer per pixel, including the antialiasing coverage mask
+     */
+    static constexpr size_t BytesPerPixel = sizeof(std::uint32_t) + 3 * sizeof(float) + sizeof(std::uint8_t);
+
+    /**
+     * @brief Bytes currently allocated for the visibility buffer
+     */
+    size_t getMemoryBytes() const
+    {
+        return triangle_.capacity() * sizeof(std::uint32_t) +
+               (bary1_.capacity() + bary2_.capacity() + depth_.capacity()) * sizeof(float) + coverage_.capacity();
+    }
+
+private:
+    static constexpr std::uint32_t NoTriangle = 0xFFFFFFFFu;
+
+    int width_;
+    int height_;
+    std::vector<std::uint32_t> triangle_; // Visible face index per pixel, or NoTriangle
+    std::vector<float> bary1_;            // Barycentric weight of the face's second corner
+    std::vector<float> bary2_;            // Barycentric weight of the face's third corner
+    std::vector<float> depth_;            // Depth of the visible surface; larger is closer
+    std::vector<std::uint8_t> coverage_;  // Samples covered by any triangle, one bit each; antialiasing only
+    bool antialias_ = false;              // Whether the last rasterize() recorded coverage
+
+    /**
+     * @brief Whether any triangle of a meshlet can be visible in this view
+     */
+    bool isClusterVisible(const Meshlet &meshlet, const View &view) const;
+
+    /**
+     * @brief Depth-test one triangle given in screen space and record it where it is nearest
+     *
+     * Without antialiasing a pixel belongs to the triangle only if its center is covered.
+     * With it, any covered sample counts, and depth and barycentrics are taken at the
+     * centroid of the covered samples, which always lies inside the triangle.
+     *
+     * @return The number of pixels the triangle covered
+     */
+    std::uint64_t rasterizeTriangle(std::uint32_t face, const float x[3], const float y[3], const float z[3]);
+};
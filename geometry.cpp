@@ -32,4 +32,19 @@ std::ostream &operator<<(std::ostream &os, const vec3 &v)
 {
     os << "(" << v.x << ", " << v.y << ", " << v.z << ")";
     return os;
-}
\ No newline at end of file
+}
+
+// Multiply the 3x3 parts and carry the translation through the left-hand transform
+Transform Transform::operator*(const Transform &t) const
+{
+    Transform r;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            r.m[i][j] = m[i][0] * t.m[0][j] + m[i][1] * t.m[1][j] + m[i][2] * t.m[2][j];
+        }
+        r.m[i][3] += m[i][3];
+    }
+    return r;
+}
@@ -166,4 +166,81 @@ public:
      * std::cout << v;  // Outputs: (1, 2, 3)
      */
     friend std::ostream &operator<<(std::ostream &os, const vec3 &v);
-};
\ No newline at end of file
+};
+
+/**
+ * @brief An affine transform: a 3x3 linear part plus a translation
+ *
+ * Affine transforms place copies of a model in the scene. A point is transformed as:
+ * p' = M * p + t
+ *
+ * This is used for:
+ * - Positioning instances of a shared model
+ * - Scaling and rotating objects
+ * - Combining several placements into one
+ */
+class Transform
+{
+public:
+    float m[3][4]; // Row-major 3x4 matrix; column 3 holds the translation
+
+    /**
+     * @brief Default constructor - creates the identity transform
+     */
+    Transform() : m{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}} {}
+
+    /**
+     * @brief Move points by (x, y, z)
+     */
+    static Transform translation(float x, float y, float z)
+    {
+        Transform t;
+        t.m[0][3] = x;
+        t.m[1][3] = y;
+        t.m[2][3] = z;
+        return t;
+    }
+
+    /**
+     * @brief Scale points uniformly about the origin
+     */
+    static Transform scale(float s)
+    {
+        Transform t;
+        t.m[0][0] = t.m[1][1] = t.m[2][2] = s;
+        return t;
+    }
+
+    /**
+     * @brief Rotate points about the vertical (y) axis
+     * @param radians Rotation angle; positive turns x towards -z
+     */
+    static Transform rotationY(float radians)
+    {
+        Transform t;
+        float c = std::cos(radians), s = std::sin(radians);
+        t.m[0][0] = c;
+        t.m[0][2] = s;
+        t.m[2][0] = -s;
+        t.m[2][2] = c;
+        return t;
+    }
+
+    /**
+     * @brief Compose two transforms
+     *
+     * (A * B).apply(p) == A.apply(B.apply(p)): the right-hand transform runs first.
+     */
+    Transform operator*(const Transform &t) const;
+
+    /**
+     * @brief Transform a point
+     */
+    vec3 apply(const vec3 &p) const
+    {
+        return vec3(
+            m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+            m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+            m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]);
+    }
+};
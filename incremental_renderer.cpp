@@ -0,0 +1,266 @@
+#include "incremental_renderer.h"
+#include <algorithm>
+#include <stdexcept>
+#include "stats.h"
+
+IncrementalRenderer::IncrementalRenderer(int width, int height, int tileSize)
+    : width_(width), height_(height), tileSize_(tileSize),
+      tilesX_((width + tileSize - 1) / std::max(tileSize, 1)),
+      tilesY_((height + tileSize - 1) / std::max(tileSize, 1)),
+      framebuffer_(width, height, TGAImage::RGB)
+{
+    if (width <= 0 || height <= 0 || tileSize <= 0)
+    {
+        throw std::invalid_argument("Incremental render dimensions must be positive");
+    }
+    tiles_.resize(static_cast<size_t>(tilesX_) * tilesY_);
+    dirtyTiles_.resize(tiles_.size());
+    unwrittenTiles_.resize(tiles_.size());
+}
+
+int IncrementalRenderer::addObject(const Model &model, const Transform &transform, TGAColor color)
+{
+    Object object;
+    object.model = &model;
+    object.transform = transform;
+    object.color = color;
+    object.seen.assign(model.getUniqueEdges().size(), 0);
+    objects_.push_back(std::move(object));
+    return static_cast<int>(objects_.size() - 1);
+}
+
+void IncrementalRenderer::setTransform(int object, const Transform &transform)
+{
+    objects_.at(object).transform = transform;
+    objects_[object].dirty = true;
+}
+
+void IncrementalRenderer::setView(const View &view)
+{
+    view_ = view;
+    viewDirty_ = true;
+}
+
+Rect IncrementalRenderer::edgeBounds(const Object &object, const std::pair<int, int> &edge) const
+{
+    const int x0 = object.screenX[edge.first], x1 = object.screenX[edge.second];
+    const int y0 = object.screenY[edge.first], y1 = object.screenY[edge.second];
+    const Rect bounds = {std::min(x0, x1), std::min(y0, y1), std::max(x0, x1) + 1, std::max(y0, y1) + 1};
+    return bounds.intersect({0, 0, width_, height_});
+}
+
+void IncrementalRenderer::markDirty(const Rect &rect)
+{
+    if (rect.empty())
+    {
+        return;
+    }
+    for (int ty = rect.y0 / tileSize_; ty <= (rect.y1 - 1) / tileSize_; ty++)
+    {
+        for (int tx = rect.x0 / tileSize_; tx <= (rect.x1 - 1) / tileSize_; tx++)
+        {
+            dirtyTiles_[static_cast<size_t>(ty) * tilesX_ + tx] = 1;
+        }
+    }
+}
+
+void IncrementalRenderer::unindex(int object)
+{
+    // An object's edges can only be in the tiles under its previous bounds
+    const Rect &rect = objects_[object].bounds;
+    if (rect.empty())
+    {
+        return;
+    }
+    for (int ty = rect.y0 / tileSize_; ty <= (rect.y1 - 1) / tileSize_; ty++)
+    {
+        for (int tx = rect.x0 / tileSize_; tx <= (rect.x1 - 1) / tileSize_; tx++)
+        {
+            auto &tile = tiles_[static_cast<size_t>(ty) * tilesX_ + tx];
+            tile.erase(std::remove_if(tile.begin(), tile.end(),
+                                      [&](const PrimitiveRef &ref)
+                                      { return ref.object == object; }),
+                       tile.end());
+        }
+    }
+}
+
+void IncrementalRenderer::reindex(int object)
+{
+    Object &o = objects_[object];
+    projectVertices(*o.model, o.transform, view_, width_, height_, o.screenX, o.screenY);
+
+    o.bounds = {};
+    const auto &edges = o.model->getUniqueEdges();
+    for (size_t e = 0; e < edges.size(); e++)
+    {
+        const Rect rect = edgeBounds(o, edges[e]);
+        if (rect.empty())
+        {
+            continue;
+        }
+        o.bounds = o.bounds.unite(rect);
+        for (int ty = rect.y0 / tileSize_; ty <= (rect.y1 - 1) / tileSize_; ty++)
+        {
+            for (int tx = rect.x0 / tileSize_; tx <= (rect.x1 - 1) / tileSize_; tx++)
+            {
+                tiles_[static_cast<size_t>(ty) * tilesX_ + tx].push_back({object, static_cast<int>(e)});
+            }
+        }
+    }
+}
+
+std::vector<Rect> IncrementalRenderer::mergeTiles(const std::vector<std::uint8_t> &tiles) const
+{
+    // Turn runs of marked tiles into rectangles, growing a rectangle downwards while the
+    // next tile row has a run with exactly the same columns
+    std::vector<Rect> rects;
+    std::vector<Rect> open;
+    for (int ty = 0; ty < tilesY_; ty++)
+    {
+        std::vector<Rect> runs;
+        for (int tx = 0; tx < tilesX_;)
+        {
+            if (!tiles[static_cast<size_t>(ty) * tilesX_ + tx])
+            {
+                tx++;
+                continue;
+            }
+            int end = tx;
+            while (end < tilesX_ && tiles[static_cast<size_t>(ty) * tilesX_ + end])
+            {
+                end++;
+            }
+            runs.push_back({tx * tileSize_, ty * tileSize_, std::min(end * tileSize_, width_),
+                            std::min((ty + 1) * tileSize_, height_)});
+            tx = end;
+        }
+
+        std::vector<Rect> stillOpen;
+        for (Rect &run : runs)
+        {
+            auto match = std::find_if(open.begin(), open.end(), [&](const Rect &r)
+                                      { return r.x0 == run.x0 && r.x1 == run.x1 && r.y1 == run.y0; });
+            if (match != open.end())
+            {
+                run.y0 = match->y0;
+                match->x1 = match->x0; // Consumed: extended by run
+            }
+            stillOpen.push_back(run);
+        }
+        for (const Rect &r : open)
+        {
+            if (r.x1 != r.x0)
+            {
+                rects.push_back(r);
+            }
+        }
+        open = std::move(stillOpen);
+    }
+    rects.insert(rects.end(), open.begin(), open.end());
+    return rects;
+}
+
+void IncrementalRenderer::collectDirtyRects()
+{
+    dirtyRects_ = mergeTiles(dirtyTiles_);
+    // Several renders may pass between writes; the file needs every one of their changes
+    for (size_t i = 0; i < dirtyTiles_.size(); i++)
+    {
+        unwrittenTiles_[i] |= dirtyTiles_[i];
+    }
+    std::fill(dirtyTiles_.begin(), dirtyTiles_.end(), 0);
+}
+
+void IncrementalRenderer::redraw(const Rect &rect)
+{
+    framebuffer_.clear(rect.x0, rect.y0, rect.x1 - rect.x0, rect.y1 - rect.y0);
+    STATS_ADD(PixelsRedrawn, rect.area());
+
+    // Gather each intersecting edge once, then draw in scene order so overlapping
+    // edges of different colors resolve exactly as in a full redraw
+    stamp_++;
+    std::vector<PrimitiveRef> primitives;
+    for (int ty = rect.y0 / tileSize_; ty <= (rect.y1 - 1) / tileSize_; ty++)
+    {
+        for (int tx = rect.x0 / tileSize_; tx <= (rect.x1 - 1) / tileSize_; tx++)
+        {
+            for (const PrimitiveRef &ref : tiles_[static_cast<size_t>(ty) * tilesX_ + tx])
+            {
+                std::uint32_t &seen = objects_[ref.object].seen[ref.edge];
+                if (seen != stamp_)
+                {
+                    seen = stamp_;
+                    primitives.push_back(ref);
+                }
+            }
+        }
+    }
+    std::sort(primitives.begin(), primitives.end(), [](const PrimitiveRef &a, const PrimitiveRef &b)
+              { return a.object != b.object ? a.object < b.object : a.edge < b.edge; });
+
+    for (const PrimitiveRef &ref : primitives)
+    {
+        const Object &o = objects_[ref.object];
+        const auto &edge = o.model->getUniqueEdges()[ref.edge];
+        line(o.screenX[edge.first], o.screenY[edge.first],
+             o.screenX[edge.second], o.screenY[edge.second], framebuffer_, o.color, rect);
+    }
+}
+
+const std::vector<Rect> &IncrementalRenderer::render()
+{
+    if (viewDirty_)
+    {
+        markDirty({0, 0, width_, height_});
+    }
+
+    for (size_t i = 0; i < objects_.size(); i++)
+    {
+        Object &o = objects_[i];
+        if (!o.dirty && !viewDirty_)
+        {
+            continue;
+        }
+        // The old footprint must be erased and the new one drawn
+        markDirty(o.bounds);
+        unindex(static_cast<int>(i));
+        reindex(static_cast<int>(i));
+        markDirty(o.bounds);
+        o.dirty = false;
+    }
+    viewDirty_ = false;
+
+    collectDirtyRects();
+    STATS_SCOPED_TIMER(Rasterization);
+    for (const Rect &rect : dirtyRects_)
+    {
+        redraw(rect);
+    }
+    return dirtyRects_;
+}
+
+bool IncrementalRenderer::write(const std::string &filename)
+{
+    if (filename != writtenFile_)
+    {
+        if (!framebuffer_.write_tga_file(filename, true, false))
+        {
+            return false;
+        }
+        writtenFile_ = filename;
+        std::fill(unwrittenTiles_.begin(), unwrittenTiles_.end(), 0);
+        return true;
+    }
+    for (const Rect &rect : mergeTiles(unwrittenTiles_))
+    {
+        if (!framebuffer_.update_tga_file(filename, rect.x0, rect.y0, rect.x1 - rect.x0, rect.y1 - rect.y0))
+        {
+            // The file is now partly stale; the next write() starts over
+            writtenFile_.clear();
+            return false;
+        }
+    }
+    std::fill(unwrittenTiles_.begin(), unwrittenTiles_.end(), 0);
+    return true;
+}
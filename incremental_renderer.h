@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "geometry.h"
+#include "model.h"
+#include "rasterizer.h"
+#include "tgaimage.h"
+
+/**
+ * @brief Keeps a rendered frame and redraws only what changed since the last frame
+ *
+ * Each scene object remembers its screen-space bounds. When objects move, the union of
+ * their previous and current bounds is marked dirty on a tile grid. Only dirty tiles are
+ * cleared and redrawn, and a tile index of edges means only primitives that intersect the
+ * dirty region are rasterized. A view change dirties the whole frame.
+ *
+ * The same dirty rectangles let write() patch just the changed spans of an uncompressed
+ * TGA file, so interactive previews scale with the size of the change, not of the frame.
+ */
+class IncrementalRenderer
+{
+public:
+    /**
+     * @brief Construct a renderer with an empty scene
+     * @param width Frame width in pixels
+     * @param height Frame height in pixels
+     * @param tileSize Edge length of the tiles used to track dirty regions and index edges
+     */
+    IncrementalRenderer(int width, int height, int tileSize = 32);
+
+    /**
+     * @brief Add a model to the scene; the model must outlive the renderer
+     * @return Handle used to move the object later
+     */
+    int addObject(const Model &model, const Transform &transform, TGAColor color);
+
+    /**
+     * @brief Move an object; its old and new footprints are redrawn on the next render()
+     */
+    void setTransform(int object, const Transform &transform);
+
+    /**
+     * @brief Change the camera; the next render() redraws the whole frame
+     */
+    void setView(const View &view);
+
+    /**
+     * @brief Bring the frame up to date with the scene
+     * @return The rectangles that were cleared and redrawn
+     */
+    const std::vector<Rect> &render();
+
+    /**
+     * @brief Write the frame as an uncompressed TGA
+     *
+     * The first call (or a call with a different filename) writes the whole file. Later
+     * calls rewrite only the rectangles redrawn since the last successful write().
+     */
+    bool write(const std::string &filename);
+
+    const TGAImage &getFramebuffer() const
+    {
+        return framebuffer_;
+    }
+
+private:
+    struct Object
+    {
+        const Model *model;
+        Transform transform;
+        TGAColor color;
+        std::vector<int> screenX;
+        std::vector<int> screenY;
+        Rect bounds;                    // Pixels covered by the object's edges in the current frame
+        bool dirty = true;              // Moved since the last render
+        std::vector<std::uint32_t> seen; // Per-edge stamp to avoid drawing an edge twice per rectangle
+    };
+
+    // Reference to one edge of one object, stored in every tile its bounding box touches
+    struct PrimitiveRef
+    {
+        int object;
+        int edge;
+    };
+
+    int width_;
+    int height_;
+    int tileSize_;
+    int tilesX_;
+    int tilesY_;
+    View view_;
+    bool viewDirty_ = false;
+    std::uint32_t stamp_ = 0;
+    std::vector<Object> objects_;
+    std::vector<std::vector<PrimitiveRef>> tiles_;
+    std::vector<std::uint8_t> dirtyTiles_;
+    std::vector<std::uint8_t> unwrittenTiles_; // Redrawn but not yet patched into writtenFile_
+    std::vector<Rect> dirtyRects_;
+    TGAImage framebuffer_;
+    std::string writtenFile_;
+
+    Rect edgeBounds(const Object &object, const std::pair<int, int> &edge) const;
+    void markDirty(const Rect &rect);
+    void unindex(int object);
+    void reindex(int object);
+    std::vector<Rect> mergeTiles(const std::vector<std::uint8_t> &tiles) const;
+    void collectDirtyRects();
+    void redraw(const Rect &rect);
+};
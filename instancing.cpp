@@ -0,0 +1,159 @@
+#include "instancing.h"
+#include <algorithm>
+#include <cmath>
+#include "stats.h"
+
+namespace
+{
+/**
+ * @brief Instance transform and view folded into one affine map straight to pixels
+ *
+ * screenX = x[0] * v.x + x[1] * v.y + x[2] * v.z + x[3], likewise for screenY.
+ */
+struct ScreenTransform
+{
+    float x[4];
+    float y[4];
+};
+
+ScreenTransform toScreenTransform(const Transform &t, const View &view, int width, int height)
+{
+    // toScreenPosition() is affine, so it folds into the transform: a scale of
+    // zoom * size / 2 and the position of the model-space origin as offset
+    ScreenTransform s;
+    const float sx = view.zoom * width / 2.0f;
+    const float sy = view.zoom * height / 2.0f;
+    for (int j = 0; j < 4; j++)
+    {
+        s.x[j] = t.m[0][j] * sx;
+        s.y[j] = t.m[1][j] * sy;
+    }
+    s.x[3] += toScreenPosition(0.0f, view.centerX, view.zoom, width);
+    s.y[3] += toScreenPosition(0.0f, view.centerY, view.zoom, height);
+    return s;
+}
+
+/**
+ * @brief Whether the model's bounding box, placed by st, overlaps the viewport
+ */
+bool overlapsViewport(const Model &model, const ScreenTransform &st, int width, int height)
+{
+    const vec3 &lo = model.getBoundsMin();
+    const vec3 &hi = model.getBoundsMax();
+    float minX = INFINITY, maxX = -INFINITY, minY = INFINITY, maxY = -INFINITY;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        const vec3 p((corner & 1) ? hi.x : lo.x, (corner & 2) ? hi.y : lo.y, (corner & 4) ? hi.z : lo.z);
+        const float x = st.x[0] * p.x + st.x[1] * p.y + st.x[2] * p.z + st.x[3];
+        const float y = st.y[0] * p.x + st.y[1] * p.y + st.y[2] * p.z + st.y[3];
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+    }
+    return maxX >= 0 && minX < width && maxY >= 0 && minY < height;
+}
+} // namespace
+
+size_t InstancedRenderer::draw(const Model &model, const std::vector<Transform> &instances, const View &view,
+                               TGAImage &framebuffer, TGAColor color)
+{
+    const int width = framebuffer.width();
+    const int height = framebuffer.height();
+    const size_t vertexCount = model.getVertexCount();
+    const std::vector<vec3> &vertices = model.getVertices();
+    screenX_.resize(vertexCount * BatchSize);
+    screenY_.resize(vertexCount * BatchSize);
+
+    size_t drawn = 0;
+    size_t next = 0;
+    while (next < instances.size())
+    {
+        // Fill a batch with instances that survive culling, stored structure-of-arrays
+        alignas(32) float coeff[8][BatchSize];
+        int lanes = 0;
+        {
+            STATS_SCOPED_TIMER(Projection);
+            for (; next < instances.size() && lanes < BatchSize; next++)
+            {
+                ScreenTransform st = toScreenTransform(instances[next], view, width, height);
+                if (!overlapsViewport(model, st, width, height))
+                {
+                    STATS_ADD(InstancesCulled, 1);
+                    continue;
+                }
+                for (int j = 0; j < 4; j++)
+                {
+                    coeff[j][lanes] = st.x[j];
+                    coeff[4 + j][lanes] = st.y[j];
+                }
+                lanes++;
+            }
+            // Pad unused lanes so the inner loop always runs the full batch width
+            for (int lane = lanes; lane < BatchSize; lane++)
+            {
+                for (int j = 0; j < 8; j++)
+                {
+                    coeff[j][lane] = 0.0f;
+                }
+            }
+            if (lanes == 0)
+            {
+                break;
+            }
+
+            // Each vertex is read once and projected for every lane of the batch
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                const vec3 &v = vertices[i];
+                int *outX = &screenX_[i * BatchSize];
+                int *outY = &screenY_[i * BatchSize];
+                for (int lane = 0; lane < BatchSize; lane++)
+                {
+                    outX[lane] = toPixel(coeff[0][lane] * v.x + coeff[1][lane] * v.y + coeff[2][lane] * v.z + coeff[3][lane]);
+                    outY[lane] = toPixel(coeff[4][lane] * v.x + coeff[5][lane] * v.y + coeff[6][lane] * v.z + coeff[7][lane]);
+                }
+            }
+        }
+
+        STATS_SCOPED_TIMER(Rasterization);
+        for (int lane = 0; lane < lanes; lane++)
+        {
+            for (const auto &edge : model.getUniqueEdges())
+            {
+                const size_t a = static_cast<size_t>(edge.first) * BatchSize + lane;
+                const size_t b = static_cast<size_t>(edge.second) * BatchSize + lane;
+                line(screenX_[a], screenY_[a], screenX_[b], screenY_[b], framebuffer, color);
+            }
+        }
+        STATS_ADD(InstancesDrawn, lanes);
+        drawn += lanes;
+    }
+    return drawn;
+}
+
+std::vector<Transform> gridInstances(const Model &model, int count)
+{
+    std::vector<Transform> instances;
+    if (count <= 0)
+    {
+        return instances;
+    }
+
+    // Fit each copy's bounding box into one cell of a cols x cols grid over [-1, 1]
+    const int cols = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+    const vec3 size = model.getBoundsMax() - model.getBoundsMin();
+    const vec3 center = (model.getBoundsMin() + model.getBoundsMax()) * 0.5f;
+    const float extent = std::max(std::max(size.x, size.y), 1e-6f);
+    const float cell = 2.0f / cols;
+    const float scale = cell / extent;
+
+    for (int i = 0; i < count; i++)
+    {
+        const float x = -1.0f + cell * (i % cols + 0.5f);
+        const float y = -1.0f + cell * (i / cols + 0.5f);
+        instances.push_back(Transform::translation(x, y, 0.0f) * Transform::scale(scale) *
+                            Transform::translation(-center.x, -center.y, -center.z));
+    }
+    return instances;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+#include "geometry.h"
+#include "model.h"
+#include "rasterizer.h"
+#include "tgaimage.h"
+
+/**
+ * @brief Draws many transformed copies of one shared model
+ *
+ * Instances share the model's vertex and edge arrays and differ only by a Transform,
+ * so memory stays constant in the number of instances. Transforms are processed in
+ * batches of BatchSize instances: each vertex is loaded once per batch and projected
+ * for every instance in the batch with a structure-of-arrays loop the compiler can
+ * vectorize. Instances whose transformed bounding box misses the viewport are culled
+ * before any per-vertex work.
+ */
+class InstancedRenderer
+{
+public:
+    static constexpr int BatchSize = 8;
+
+    /**
+     * @brief Draw the wireframe of every instance of a model
+     * @param model The shared model
+     * @param instances One transform per copy
+     * @param view Camera used for the projection
+     * @param framebuffer Image to draw into; its size defines the viewport
+     * @param color Color of the edges
+     * @return The number of instances that survived culling and were drawn
+     */
+    size_t draw(const Model &model, const std::vector<Transform> &instances, const View &view,
+                TGAImage &framebuffer, TGAColor color);
+
+private:
+    // Screen positions for one batch, laid out [vertex][lane]; reused across calls
+    std::vector<int> screenX_;
+    std::vector<int> screenY_;
+};
+
+/**
+ * @brief Lay out copies of a model on a square grid that fills the default view
+ * @param model The model being instanced; its bounds decide the spacing
+ * @param count Number of copies
+ * @return One transform per copy
+ */
+std::vector<Transform> gridInstances(const Model &model, int count);
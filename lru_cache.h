@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * @brief A string-keyed cache that evicts the least recently used entries past a byte budget
+ *
+ * Values are held through shared_ptr, so an entry evicted while a caller is still using it
+ * stays alive until that caller releases it. The caller supplies each entry's size since
+ * only it knows what the value owns on the heap.
+ */
+template <typename Value>
+class LRUCache
+{
+public:
+    /**
+     * @brief Construct a cache
+     * @param capacityBytes Total size of entries kept before the oldest are evicted
+     */
+    explicit LRUCache(size_t capacityBytes) : capacityBytes_(capacityBytes) {}
+
+    /**
+     * @brief Look up an entry and mark it most recently used
+     * @param key The entry key
+     * @return The cached value, or nullptr on a miss
+     */
+    std::shared_ptr<const Value> get(const std::string &key)
+    {
+        auto it = index_.find(key);
+        if (it == index_.end())
+        {
+            misses_++;
+            return nullptr;
+        }
+        hits_++;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->value;
+    }
+
+    /**
+     * @brief Insert or replace an entry, then evict old entries until the cache fits its budget
+     *
+     * An entry larger than the whole budget is not kept.
+     *
+     * @param key The entry key
+     * @param value The value to cache
+     * @param bytes Size charged against the budget for this entry
+     */
+    void put(const std::string &key, std::shared_ptr<const Value> value, size_t bytes)
+    {
+        erase(key);
+        if (bytes > capacityBytes_)
+        {
+            return;
+        }
+        entries_.push_front({key, std::move(value), bytes});
+        index_[key] = entries_.begin();
+        sizeBytes_ += bytes;
+        while (sizeBytes_ > capacityBytes_)
+        {
+            erase(entries_.back().key);
+        }
+    }
+
+    /**
+     * @brief Remove an entry if present
+     * @param key The entry key
+     */
+    void erase(const std::string &key)
+    {
+        auto it = index_.find(key);
+        if (it == index_.end())
+        {
+            return;
+        }
+        sizeBytes_ -= it->second->bytes;
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+
+    size_t getSizeBytes() const { return sizeBytes_; }
+    size_t getCapacityBytes() const { return capacityBytes_; }
+    size_t getEntryCount() const { return entries_.size(); }
+    size_t getHits() const { return hits_; }
+    size_t getMisses() const { return misses_; }
+
+private:
+    struct Entry
+    {
+        std::string key;
+        std::shared_ptr<const Value> value;
+        size_t bytes;
+    };
+
+    size_t capacityBytes_;
+    size_t sizeBytes_ = 0;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+    std::list<Entry> entries_; // Most recently used first
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> index_;
+};
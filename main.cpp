@@ -1,8 +1,19 @@
-#include <cmath>
+#include <algorithm>
+#include <cstdio>
 #include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
 #include "tgaimage.h"
 #include "model.h"
 #include "obj_loader.h"
+#include "rasterizer.h"
+#include "band_renderer.h"
+#include "render_service.h"
+#include "instancing.h"
+#include "incremental_renderer.h"
+#include "deferred_renderer.h"
+#include "stats.h"
 
 // Define color constants in BGRA format (Blue, Green, Red, Alpha)
 // Each color component ranges from 0-255
@@ -12,106 +23,284 @@ constexpr TGAColor red = {{0, 0, 255, 255}};       // Pure red
 constexpr TGAColor blue = {{255, 128, 64, 255}};   // Custom blue
 constexpr TGAColor yellow = {{0, 200, 255, 255}};  // Custom yellow
 
-void line(int startX, int startY, int endX, int endY, TGAImage &framebuffer, TGAColor color)
+/**
+ * @brief Command line options for a render
+ */
+struct Options
 {
-    // Check if the line is steep (more vertical than horizontal) rises more than it runs
-    bool steep = std::abs(endY - startY) > std::abs(endX - startX);
-    if (steep)
-    {
-        std::swap(startX, startY);
-        std::swap(endX, endY);
-    }
-    // Iterate through each x-coordinate between start and end points
-    for (int x = startX; x <= endX; x++)
+    int width = 800;               // Output width in pixels
+    int height = 800;              // Output height in pixels
+    int bandHeight = 0;            // Rows per band; 0 renders the full frame in memory
+    std::string output = "framebuffer.tga";
+    std::string statsPath;         // Where to write per-stage stats as JSON; "-" for stdout
+    int instances = 0;             // Draw this many copies of the model on a grid
+    int frames = 0;                // Animate this many frames, redrawing only dirty regions
+    View view;                     // Camera for the projection
+    bool shade = false;            // Render textured, lit triangles instead of a wireframe
+    bool antialias = false;        // Smooth wireframe lines and triangle silhouettes
+    bool serve = false;            // Run as a resident service reading jobs from stdin
+    std::string socketPath;        // Run as a resident service on this Unix socket
+};
+
+/**
+ * @brief Parse command line options
+ *
+ * Supported flags:
+ *   --size WxH          Output dimensions (up to 65535x65535)
+ *   --band-height N     Render in strips of N rows and stream them to disk
+ *   --output FILE       Output TGA path
+ *   --instances N       Draw N instanced copies of the model on a grid
+ *   --frames N          Animate N frames, moving the first copy and patching only changed pixels
+ *   --view CX,CY,ZOOM   Center the view on (CX, CY) and magnify by ZOOM
+ *   --stats FILE        Write per-stage timers and counters as JSON ("-" for stdout); in resident
+ *                       mode each job's stats are appended to its response instead
+ *   --shade             Shade triangles with the model's diffuse, normal and specular maps
+ *   --aa                Antialias the wireframe or the shaded silhouettes in a single pass
+ *   --serve             Keep running and read render jobs from stdin, one per line
+ *   --socket PATH       Keep running and read render jobs from a Unix socket
+ *
+ * @throws std::runtime_error on unknown or malformed flags
+ */
+Options parseOptions(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
     {
-        if (startX > endX)
-        {
-            // Swap the start and end points if startX is greater than endX
-            // This ensures we always iterate from left to right
-            std::swap(startX, endX);
-            std::swap(startY, endY);
-        }
-        // Calculate the interpolation factor (t) between 0 and 1
-        // This represents how far along the line we are from start to end
-        // t = 0 means we're at the start point
-        // t = 1 means we're at the end point
-        float interpolationFactor = (x - startX) / static_cast<float>(endX - startX);
-
-        // Use linear interpolation to find the corresponding y-coordinate
-        // y = y1 + (y2 - y1) * t
-        // This formula gives us a point that lies on the line between (startX, startY) and (endX, endY)
-        // The interpolation ensures we get a straight line by calculating the exact y position
-        // for each x position based on the ratio of how far we've progressed along the line
-        int y = startY + (endY - startY) * interpolationFactor;
-
-        // Set the pixel at the calculated (x,y) position to the specified color
-        // For steep lines (where vertical change > horizontal change), we transpose the coordinates
-        // This is crucial because:
-        // 1. Steep lines have large y-changes between x-steps, causing gaps because we are iterating through x-coordinates.
-        // 2. By transposing, we convert the steep line into a shallow line relative to our iteration
-        // 3. This gives us more sampling points along the line's primary axis of change
-        // 4. The result is a continuous line with no gaps, regardless of angle
-        // Example: For a line from (0,0) to (1,10):
-        // - Without transposing: Only 2 points (at x=0 and x=1)
-        // - With transposing: 10 points (at y=0 through y=10)
-        if (steep)
-        {
-            framebuffer.set(y, x, color);
+        std::string arg = argv[i];
+        if (arg == "--serve")
+        {
+            options.serve = true;
+            continue;
+        }
+        if (arg == "--shade")
+        {
+            options.shade = true;
+            continue;
+        }
+        if (arg == "--aa")
+        {
+            options.antialias = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            throw std::runtime_error("Missing value for " + arg);
+        }
+        std::string value = argv[++i];
+        if (arg == "--size")
+        {
+            if (std::sscanf(value.c_str(), "%dx%d", &options.width, &options.height) != 2 ||
+                options.width <= 0 || options.height <= 0 ||
+                options.width > TGAImage::max_dimension || options.height > TGAImage::max_dimension)
+            {
+                throw std::runtime_error("Invalid size: " + value);
+            }
+        }
+        else if (arg == "--band-height")
+        {
+            char trailing;
+            if (std::sscanf(value.c_str(), "%d%c", &options.bandHeight, &trailing) != 1 || options.bandHeight <= 0)
+            {
+                throw std::runtime_error("Invalid band height: " + value);
+            }
+        }
+        else if (arg == "--output")
+        {
+            options.output = value;
+        }
+        else if (arg == "--instances")
+        {
+            options.instances = std::stoi(value);
+        }
+        else if (arg == "--frames")
+        {
+            options.frames = std::stoi(value);
+        }
+        else if (arg == "--view")
+        {
+            if (std::sscanf(value.c_str(), "%f,%f,%f", &options.view.centerX, &options.view.centerY, &options.view.zoom) != 3 ||
+                !options.view.valid())
+            {
+                throw std::runtime_error("Invalid view: " + value);
+            }
+        }
+        else if (arg == "--stats")
+        {
+            options.statsPath = value;
+        }
+        else if (arg == "--socket")
+        {
+            options.socketPath = value;
         }
         else
         {
-            framebuffer.set(x, y, color);
+            throw std::runtime_error("Unknown option: " + arg);
         }
     }
+
+    // Banded mode only streams wireframes; refuse modes it would silently ignore
+    if (options.bandHeight > 0 && (options.shade || options.antialias || options.instances > 0 || options.frames > 0))
+    {
+        throw std::runtime_error("--band-height cannot be combined with --shade, --aa, --instances or --frames");
+    }
+    return options;
 }
 
-int main(int argc, char **argv)
+/**
+ * @brief Load a texture if the file exists
+ * @return The decoded texture, or nullptr if it is missing or unreadable
+ */
+std::shared_ptr<const TGAImage> loadTexture(const std::string &path)
 {
-    // Define the dimensions of our framebuffer (image)
-    constexpr int width = 800;  // Increased width to accommodate the model
-    constexpr int height = 800; // Increased height to accommodate the model
+    if (!std::filesystem::exists(path))
+    {
+        return nullptr;
+    }
+    auto texture = std::make_shared<TGAImage>();
+    return texture->read_tga_file(path) ? texture : nullptr;
+}
 
-    // Create a new TGA image with specified dimensions and RGB color mode
-    TGAImage framebuffer(width, height, TGAImage::RGB);
+/**
+ * @brief Emit the stats collected during this run, if requested
+ * @return false if the stats file could not be written
+ */
+bool writeStats(const Options &options)
+{
+    if (options.statsPath.empty())
+    {
+        return true;
+    }
+    if (options.statsPath == "-")
+    {
+        stats::writeJson(std::cout);
+        return true;
+    }
+    std::ofstream out(options.statsPath);
+    stats::writeJson(out);
+    return out.good();
+}
 
+int main(int argc, char **argv)
+{
     try
     {
+        Options options = parseOptions(argc, argv);
+        const int width = options.width;
+        const int height = options.height;
+
+        // Resident mode: models, textures and framebuffers stay cached between jobs
+        if (options.serve || !options.socketPath.empty())
+        {
+            ServiceConfig config;
+            config.reportStats = !options.statsPath.empty();
+            RenderService service(config);
+            if (!options.socketPath.empty())
+            {
+                return service.serveSocket(options.socketPath) ? 0 : 1;
+            }
+            service.serve(std::cin, std::cout);
+            return 0;
+        }
+
+        // Progress goes to stderr when stdout carries the stats JSON, so the JSON stays parseable
+        std::ostream &progress = options.statsPath == "-" ? std::cerr : std::cout;
+
         // Get the absolute path to the model file by going up one directory from the build folder
         std::filesystem::path currentPath = std::filesystem::current_path();
         std::filesystem::path projectRoot = currentPath.parent_path();
         std::filesystem::path modelPath = projectRoot / "obj" / "diablo3_pose" / "diablo3_pose.obj";
 
-        std::cout << "Loading model from: " << modelPath << std::endl;
+        progress << "Loading model from: " << modelPath << std::endl;
 
         // Load the diablo3_pose.obj model
         Model model = OBJLoader::loadFromFile(modelPath.string());
 
         // Print model statistics
-        std::cout << "Model loaded successfully:" << std::endl;
-        std::cout << "Number of vertices: " << model.getVertexCount() << std::endl;
-        std::cout << "Number of edges: " << model.getEdgeCount() << std::endl;
+        progress << "Model loaded successfully:" << std::endl;
+        progress << "Number of vertices: " << model.getVertexCount() << std::endl;
+        progress << "Number of edges: " << model.getEdgeCount() << std::endl;
 
-        // Draw all edges of the model
-        for (size_t i = 0; i < model.getEdgeCount(); i++)
+        // Poster-scale images do not fit in memory: rasterize one strip at a time
+        // and stream each strip straight to disk
+        if (options.bandHeight > 0)
         {
-            const auto &edge = model.getEdge(i);
-            const vec3 &v1 = model.getVertex(edge.first);
-            const vec3 &v2 = model.getVertex(edge.second);
+            BandedRenderer renderer(width, height, options.bandHeight);
+            if (!renderer.render(model, white, options.output, true, options.view))
+            {
+                return 1;
+            }
+            progress << "Image saved to " << options.output << " in "
+                     << renderer.getBandCount() << " bands" << std::endl;
+            return writeStats(options) ? 0 : 1;
+        }
+
+        // Interactive preview: only the area swept by the moving copy is redrawn and rewritten
+        if (options.frames > 0)
+        {
+            IncrementalRenderer renderer(width, height);
+            renderer.setView(options.view);
+            std::vector<Transform> placements = gridInstances(model, std::max(options.instances, 1));
+            for (const Transform &placement : placements)
+            {
+                renderer.addObject(model, placement, white);
+            }
+            for (int frame = 0; frame < options.frames; frame++)
+            {
+                Transform nudge = Transform::translation(0.01f * frame, 0.0f, 0.0f);
+                renderer.setTransform(0, nudge * placements[0]);
+                long long dirtyArea = 0;
+                for (const Rect &rect : renderer.render())
+                {
+                    dirtyArea += rect.area();
+                }
+                if (!renderer.write(options.output))
+                {
+                    return 1;
+                }
+                progress << "Frame " << frame << ": redrew " << 100.0 * dirtyArea / (static_cast<double>(width) * height)
+                         << "% of the image" << std::endl;
+            }
+            return writeStats(options) ? 0 : 1;
+        }
 
-            // Convert 3D coordinates to 2D screen coordinates
-            // Simple orthographic projection for now
-            int x1 = static_cast<int>((v1.x + 1.0f) * width / 2.0f);
-            int y1 = static_cast<int>((v1.y + 1.0f) * height / 2.0f);
-            int x2 = static_cast<int>((v2.x + 1.0f) * width / 2.0f);
-            int y2 = static_cast<int>((v2.y + 1.0f) * height / 2.0f);
+        // Create a new TGA image with specified dimensions and RGB color mode
+        TGAImage framebuffer(width, height, TGAImage::RGB);
 
-            // Draw the edge
-            line(x1, y1, x2, y2, framebuffer, white);
+        if (options.shade)
+        {
+            // Visibility buffer first, then one shading pass over the visible pixels
+            Material material;
+            material.diffuse = loadTexture(texturePath(modelPath.string(), "_diffuse"));
+            material.normal = loadTexture(texturePath(modelPath.string(), "_nm_tangent"));
+            material.specular = loadTexture(texturePath(modelPath.string(), "_spec"));
+
+            DeferredRenderer renderer(width, height);
+            renderer.rasterize(model, options.view, options.antialias);
+            renderer.shade(model, material, vec3(1, 1, 1), framebuffer);
+        }
+        else if (options.instances > 0)
+        {
+            // One shared model, many transforms: a crowd costs no extra vertex memory
+            InstancedRenderer renderer;
+            size_t drawn = renderer.draw(model, gridInstances(model, options.instances), options.view, framebuffer, white);
+            progress << "Instances drawn: " << drawn << " of " << options.instances << std::endl;
+        }
+        else
+        {
+            // Draw all edges of the model
+            drawWireframe(model, options.view, framebuffer, white, options.antialias);
         }
 
         // Save the framebuffer to a TGA image file
-        framebuffer.write_tga_file("framebuffer.tga");
-        std::cout << "Image saved to framebuffer.tga" << std::endl;
+        if (!framebuffer.write_tga_file(options.output))
+        {
+            return 1;
+        }
+        progress << "Image saved to " << options.output << std::endl;
+        if (!writeStats(options))
+        {
+            return 1;
+        }
     }
     catch (const std::exception &e)
     {
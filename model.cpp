@@ -0,0 +1,289 @@
+#include "model.h"
+#include <algorithm>
+#include <cmath>
+
+void Model::computeTangents()
+{
+    std::vector<vec3> tangentSums(vertices_.size());
+    std::vector<vec3> bitangentSums(vertices_.size());
+    std::vector<vec3> normalSums(vertices_.size());
+
+    for (const Face &face : faces_)
+    {
+        const vec3 &p0 = vertices_[face.vertex[0]];
+        const vec3 edge1 = vertices_[face.vertex[1]] - p0;
+        const vec3 edge2 = vertices_[face.vertex[2]] - p0;
+
+        // Prefer the file's normals; fall back to the face normal
+        const vec3 faceNormal = edge1.cross(edge2);
+        for (int k = 0; k < 3; k++)
+        {
+            normalSums[face.vertex[k]] = normalSums[face.vertex[k]] +
+                                         (face.normal[k] >= 0 ? normals_[face.normal[k]] : faceNormal);
+        }
+
+        if (!face.hasUVs())
+        {
+            continue;
+        }
+        // Solve edge = du * T + dv * B for the directions of increasing u (T) and v (B)
+        const vec3 &uv0 = uvs_[face.uv[0]];
+        const vec3 duv1 = uvs_[face.uv[1]] - uv0;
+        const vec3 duv2 = uvs_[face.uv[2]] - uv0;
+        const float det = duv1.x * duv2.y - duv2.x * duv1.y;
+        if (std::abs(det) < 1e-12f)
+        {
+            continue;
+        }
+        const vec3 tangent = (edge1 * duv2.y - edge2 * duv1.y) / det;
+        const vec3 bitangent = (edge2 * duv1.x - edge1 * duv2.x) / det;
+        for (int k = 0; k < 3; k++)
+        {
+            tangentSums[face.vertex[k]] = tangentSums[face.vertex[k]] + tangent;
+            bitangentSums[face.vertex[k]] = bitangentSums[face.vertex[k]] + bitangent;
+        }
+    }
+
+    tangents_.resize(vertices_.size());
+    bitangentSigns_.resize(vertices_.size());
+    for (size_t i = 0; i < vertices_.size(); i++)
+    {
+        const vec3 n = normalSums[i].normalize();
+        vec3 t = tangentSums[i] - n * n.dot(tangentSums[i]);
+        if (t.length() < 1e-12f)
+        {
+            // No usable texture mapping: pick any direction orthogonal to the normal
+            t = std::abs(n.x) < 0.9f ? vec3(1, 0, 0).cross(n) : vec3(0, 1, 0).cross(n);
+        }
+        tangents_[i] = t.normalize();
+        bitangentSigns_[i] = n.cross(tangents_[i]).dot(bitangentSums[i]) < 0.0f ? -1.0f : 1.0f;
+    }
+}
+
+void Model::buildMeshlets(unsigned maxVertices, unsigned maxTriangles)
+{
+    maxVertices = std::clamp(maxVertices, 3u, 256u);
+    maxTriangles = std::max(maxTriangles, 1u);
+    meshlets_.clear();
+    meshletVertices_.clear();
+    meshletTriangles_.clear();
+    meshletFaces_.clear();
+    meshletEdges_.clear();
+    looseEdges_.clear();
+    uniqueEdges_.clear();
+
+    // Faces touching each vertex, used to grow clusters across shared vertices
+    std::vector<int> adjacencyOffsets(vertices_.size() + 1, 0);
+    for (const Face &face : faces_)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            adjacencyOffsets[face.vertex[k] + 1]++;
+        }
+    }
+    for (size_t i = 0; i < vertices_.size(); i++)
+    {
+        adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+    }
+    std::vector<int> adjacency(adjacencyOffsets.back());
+    std::vector<int> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t f = 0; f < faces_.size(); f++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            adjacency[cursor[faces_[f].vertex[k]]++] = static_cast<int>(f);
+        }
+    }
+
+    // Unit normal of every face, used to keep each cluster's facing coherent
+    std::vector<vec3> faceNormals(faces_.size());
+    for (size_t f = 0; f < faces_.size(); f++)
+    {
+        const vec3 &p0 = vertices_[faces_[f].vertex[0]];
+        faceNormals[f] = (vertices_[faces_[f].vertex[1]] - p0).cross(vertices_[faces_[f].vertex[2]] - p0).normalize();
+    }
+
+    std::vector<bool> used(faces_.size(), false);
+    std::vector<int> localIndex(vertices_.size(), -1);
+    std::vector<int> frontier; // Unused faces sharing a vertex with the current meshlet
+    vec3 facing;               // Sum of the current meshlet's face normals
+    size_t nextSeed = 0;
+
+    // Vertices a face would add to the current meshlet
+    auto countNewVertices = [&](const Face &face)
+    {
+        unsigned count = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            bool repeated = (k > 0 && face.vertex[k] == face.vertex[0]) || (k > 1 && face.vertex[k] == face.vertex[1]);
+            count += (localIndex[face.vertex[k]] < 0 && !repeated) ? 1 : 0;
+        }
+        return count;
+    };
+
+    // Bounds and normal cone of the meshlet at the back of meshlets_
+    auto finish = [&]()
+    {
+        Meshlet &m = meshlets_.back();
+        vec3 lo = vertices_[meshletVertices_[m.vertexOffset]], hi = lo;
+        for (unsigned i = 0; i < m.vertexCount; i++)
+        {
+            const vec3 &p = vertices_[meshletVertices_[m.vertexOffset + i]];
+            lo = vec3(std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z));
+            hi = vec3(std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z));
+            localIndex[meshletVertices_[m.vertexOffset + i]] = -1;
+        }
+        m.center = (lo + hi) * 0.5f;
+        for (unsigned i = 0; i < m.vertexCount; i++)
+        {
+            m.radius = std::max(m.radius, (vertices_[meshletVertices_[m.vertexOffset + i]] - m.center).length());
+        }
+
+        std::vector<vec3> normals;
+        vec3 axis;
+        for (unsigned t = 0; t < m.triangleCount; t++)
+        {
+            const Face &face = faces_[meshletFaces_[m.triangleOffset + t]];
+            const vec3 &p0 = vertices_[face.vertex[0]];
+            const vec3 n = (vertices_[face.vertex[1]] - p0).cross(vertices_[face.vertex[2]] - p0);
+            if (n.length() > 0.0f)
+            {
+                normals.push_back(n.normalize());
+                axis = axis + normals.back();
+            }
+        }
+        if (normals.empty() || axis.length() < 1e-6f)
+        {
+            return; // Facing is undefined or spread in all directions: keep cone culling off
+        }
+        m.coneAxis = axis.normalize();
+        m.coneCutoff = 1.0f;
+        for (const vec3 &n : normals)
+        {
+            m.coneCutoff = std::min(m.coneCutoff, m.coneAxis.dot(n));
+        }
+    };
+
+    while (true)
+    {
+        // Grow from the frontier, preferring faces that add few vertices and face the
+        // same way as the cluster so far, which keeps the normal cone narrow enough to cull
+        int next = -1;
+        float bestScore = 0.0f;
+        const vec3 axis = facing.normalize();
+        size_t kept = 0;
+        for (size_t i = 0; i < frontier.size(); i++)
+        {
+            const int candidate = frontier[i];
+            if (used[candidate])
+            {
+                continue;
+            }
+            frontier[kept++] = candidate;
+            const float score = countNewVertices(faces_[candidate]) + 2.0f * (1.0f - axis.dot(faceNormals[candidate]));
+            if (next < 0 || score < bestScore)
+            {
+                next = candidate;
+                bestScore = score;
+            }
+        }
+        frontier.resize(kept);
+        while (next < 0 && nextSeed < faces_.size())
+        {
+            if (!used[nextSeed])
+            {
+                next = static_cast<int>(nextSeed);
+            }
+            nextSeed++;
+        }
+        if (next < 0)
+        {
+            break;
+        }
+
+        const Face &face = faces_[next];
+        const unsigned newVertices = countNewVertices(face);
+        if (meshlets_.empty() ||
+            meshlets_.back().vertexCount + newVertices > maxVertices ||
+            meshlets_.back().triangleCount + 1 > maxTriangles)
+        {
+            if (!meshlets_.empty())
+            {
+                finish();
+                frontier.clear();
+                facing = vec3();
+            }
+            Meshlet meshlet;
+            meshlet.vertexOffset = static_cast<unsigned>(meshletVertices_.size());
+            meshlet.triangleOffset = static_cast<unsigned>(meshletFaces_.size());
+            meshlets_.push_back(meshlet);
+        }
+
+        Meshlet &m = meshlets_.back();
+        for (int k = 0; k < 3; k++)
+        {
+            int v = face.vertex[k];
+            if (localIndex[v] < 0)
+            {
+                localIndex[v] = static_cast<int>(m.vertexCount++);
+                meshletVertices_.push_back(v);
+                frontier.insert(frontier.end(), adjacency.begin() + adjacencyOffsets[v],
+                                adjacency.begin() + adjacencyOffsets[v + 1]);
+            }
+            meshletTriangles_.push_back(static_cast<unsigned char>(localIndex[v]));
+        }
+        meshletFaces_.push_back(next);
+        facing = facing + faceNormals[next];
+        m.triangleCount++;
+        used[next] = true;
+    }
+    if (!meshlets_.empty())
+    {
+        finish();
+    }
+
+    // Faces list every shared edge once per face; keep each edge once, lower index first
+    uniqueEdges_.reserve(edges_.size());
+    for (const auto &edge : edges_)
+    {
+        uniqueEdges_.emplace_back(std::min(edge.first, edge.second), std::max(edge.first, edge.second));
+    }
+    std::sort(uniqueEdges_.begin(), uniqueEdges_.end());
+    uniqueEdges_.erase(std::unique(uniqueEdges_.begin(), uniqueEdges_.end()), uniqueEdges_.end());
+    uniqueEdges_.shrink_to_fit();
+
+    // Hand each unique edge to the first meshlet with a triangle side along it, so
+    // wireframes can cull edges by cluster and draw shared edges only once
+    std::vector<bool> assigned(uniqueEdges_.size(), false);
+
+    for (Meshlet &m : meshlets_)
+    {
+        m.edgeOffset = static_cast<unsigned>(meshletEdges_.size() / 2);
+        for (unsigned t = 0; t < m.triangleCount; t++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                const unsigned a = getMeshletCorner(m, t, k);
+                const unsigned b = getMeshletCorner(m, t, (k + 1) % 3);
+                const int va = getMeshletVertex(m, a), vb = getMeshletVertex(m, b);
+                const std::pair<int, int> edge(std::min(va, vb), std::max(va, vb));
+                const auto found = std::lower_bound(uniqueEdges_.begin(), uniqueEdges_.end(), edge);
+                if (found == uniqueEdges_.end() || *found != edge || assigned[found - uniqueEdges_.begin()])
+                {
+                    continue;
+                }
+                assigned[found - uniqueEdges_.begin()] = true;
+                meshletEdges_.push_back(static_cast<unsigned char>(a));
+                meshletEdges_.push_back(static_cast<unsigned char>(b));
+                m.edgeCount++;
+            }
+        }
+    }
+    for (size_t i = 0; i < uniqueEdges_.size(); i++)
+    {
+        if (!assigned[i])
+        {
+            looseEdges_.push_back(uniqueEdges_[i]);
+        }
+    }
+}
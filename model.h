@@ -1,19 +1,91 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include "geometry.h" // Assuming Vec3f is defined here
 
+/**
+ * @brief A triangle of the mesh with per-corner attribute indices
+ *
+ * Each corner refers to a vertex position, a texture coordinate and a normal.
+ * Attributes missing from the source file are -1.
+ */
+struct Face
+{
+    int vertex[3] = {-1, -1, -1}; // Indices into the vertex positions
+    int uv[3] = {-1, -1, -1};     // Indices into the texture coordinates
+    int normal[3] = {-1, -1, -1}; // Indices into the normals
+
+    /**
+     * @brief Whether every corner has a texture coordinate; OBJ allows mixing per corner
+     */
+    bool hasUVs() const
+    {
+        return uv[0] >= 0 && uv[1] >= 0 && uv[2] >= 0;
+    }
+
+    /**
+     * @brief Whether every corner has a normal
+     */
+    bool hasNormals() const
+    {
+        return normal[0] >= 0 && normal[1] >= 0 && normal[2] >= 0;
+    }
+};
+
+/**
+ * @brief A small cluster of a mesh's triangles with bounds for whole-cluster culling
+ *
+ * The cluster's vertices and triangles live in the model's shared meshlet arrays:
+ * - Vertices: global vertex indices at [vertexOffset, vertexOffset + vertexCount)
+ * - Triangles: three local (0..vertexCount-1) indices each, starting at triangleOffset * 3
+ * - Faces: the global face index of each triangle, starting at triangleOffset
+ * - Edges: two local indices each, starting at edgeOffset * 2; every unique model edge
+ *   belongs to exactly one meshlet, or to the model's loose edges
+ */
+struct Meshlet
+{
+    unsigned vertexOffset = 0;
+    unsigned vertexCount = 0;
+    unsigned triangleOffset = 0;
+    unsigned triangleCount = 0;
+    unsigned edgeOffset = 0;
+    unsigned edgeCount = 0;
+    vec3 center;             // Bounding sphere of the cluster's vertices
+    float radius = 0.0f;
+    vec3 coneAxis;           // Average facing of the cluster's triangles
+    float coneCutoff = -1.0f; // Cosine of the widest angle between coneAxis and a face normal; -1 disables cone culling
+};
+
 /**
  * @brief A 3D model class that represents a mesh with vertices and edges
  *
  * This class stores the geometric data of a 3D model, including:
  * - Vertices: Points in 3D space
  * - Edges: Connections between vertices
+ * - Faces: Triangles with texture coordinates and normals, used for shading
+ * - Tangents: Per-vertex tangent frames for tangent-space normal maps
+ * - Meshlets: Clusters of faces that can be culled as a whole
  */
 class Model
 {
 private:
     std::vector<vec3> vertices_;             // List of vertices in the model
     std::vector<std::pair<int, int>> edges_; // List of edges as pairs of vertex indices
+    std::vector<Face> faces_;                // List of triangles
+    std::vector<vec3> uvs_;                  // Texture coordinates (u, v in x, y)
+    std::vector<vec3> normals_;              // Vertex normals
+    std::vector<vec3> tangents_;             // Per-vertex tangent, orthogonal to the vertex normal
+    std::vector<float> bitangentSigns_;      // Per-vertex handedness: bitangent = sign * cross(normal, tangent)
+    std::vector<Meshlet> meshlets_;          // Face clusters built by buildMeshlets()
+    std::vector<int> meshletVertices_;       // Global vertex indices referenced by each meshlet
+    std::vector<unsigned char> meshletTriangles_; // Local vertex indices, three per meshlet triangle
+    std::vector<int> meshletFaces_;          // Global face index of each meshlet triangle
+    std::vector<unsigned char> meshletEdges_; // Local vertex indices, two per meshlet edge
+    std::vector<std::pair<int, int>> looseEdges_; // Unique edges that are no side of any triangle
+    std::vector<std::pair<int, int>> uniqueEdges_; // Each edge once, lower vertex index first
+    vec3 boundsMin_;                         // Corner of the axis-aligned bounding box with the smallest coordinates
+    vec3 boundsMax_;                         // Corner with the largest coordinates
 
 public:
     /**
@@ -28,6 +100,16 @@ public:
      */
     int addVertex(const vec3 &vertex)
     {
+        // Keep the bounding box current so culling never has to rescan the vertices
+        if (vertices_.empty())
+        {
+            boundsMin_ = boundsMax_ = vertex;
+        }
+        else
+        {
+            boundsMin_ = vec3(std::min(boundsMin_.x, vertex.x), std::min(boundsMin_.y, vertex.y), std::min(boundsMin_.z, vertex.z));
+            boundsMax_ = vec3(std::max(boundsMax_.x, vertex.x), std::max(boundsMax_.y, vertex.y), std::max(boundsMax_.z, vertex.z));
+        }
         vertices_.push_back(vertex);
         return static_cast<int>(vertices_.size() - 1);
     }
@@ -42,6 +124,62 @@ public:
         edges_.emplace_back(v1, v2);
     }
 
+    /**
+     * @brief Add a texture coordinate
+     * @param uv The coordinate, with u in x and v in y
+     * @return The index of the added coordinate
+     */
+    int addUV(const vec3 &uv)
+    {
+        uvs_.push_back(uv);
+        return static_cast<int>(uvs_.size() - 1);
+    }
+
+    /**
+     * @brief Add a vertex normal
+     * @param normal The normal direction
+     * @return The index of the added normal
+     */
+    int addNormal(const vec3 &normal)
+    {
+        normals_.push_back(normal);
+        return static_cast<int>(normals_.size() - 1);
+    }
+
+    /**
+     * @brief Add a triangle
+     * @param face Attribute indices of the three corners
+     */
+    void addFace(const Face &face)
+    {
+        faces_.push_back(face);
+    }
+
+    /**
+     * @brief Compute per-vertex tangent frames from the faces' positions and texture coordinates
+     *
+     * Each face contributes the direction in which u increases across it to its three
+     * vertices. The sums are then made orthogonal to the vertex normal (Gram-Schmidt) and
+     * the handedness of the (tangent, bitangent, normal) frame is recorded. Done once at
+     * load time so shading only interpolates.
+     */
+    void computeTangents();
+
+    /**
+     * @brief Partition the faces into meshlets with bounding spheres and normal cones
+     *
+     * Clusters grow across shared vertices, preferring faces that add few vertices and
+     * face the same way as the cluster, so each stays compact with a narrow normal cone.
+     * A new cluster starts whenever one more triangle would exceed either limit.
+     * The edges are deduplicated into getUniqueEdges() and each is assigned to one meshlet
+     * containing it, so wireframes can be culled per cluster as well. Done once at load time so renderers can reject whole
+     * clusters per frame.
+     *
+     * @param maxVertices Vertex limit per meshlet (at most 256, local indices are bytes)
+     * @param maxTriangles Triangle limit per meshlet
+     */
+    void buildMeshlets(unsigned maxVertices = 64, unsigned maxTriangles = 128);
+
     /**
      * @brief Get the number of vertices in the model
      * @return The vertex count
@@ -91,10 +229,146 @@ public:
 
     /**
      * @brief Get all edges
-     * @return A const reference to the vector of edges
+     * @return A const reference to the vector of edges, with shared edges once per face
      */
     const std::vector<std::pair<int, int>> &getEdges() const
     {
         return edges_;
     }
+
+    /**
+     * @brief Get every edge exactly once, as built by buildMeshlets(); draw these, not getEdges()
+     * @return Edges sorted by vertex indices, lower index first
+     */
+    const std::vector<std::pair<int, int>> &getUniqueEdges() const
+    {
+        return uniqueEdges_;
+    }
+
+    size_t getFaceCount() const
+    {
+        return faces_.size();
+    }
+
+    const Face &getFace(int index) const
+    {
+        return faces_[index];
+    }
+
+    const vec3 &getUV(int index) const
+    {
+        return uvs_[index];
+    }
+
+    const vec3 &getNormal(int index) const
+    {
+        return normals_[index];
+    }
+
+    /**
+     * @brief Whether computeTangents() produced a frame for every vertex
+     */
+    bool hasTangents() const
+    {
+        return !tangents_.empty();
+    }
+
+    /**
+     * @brief Get the tangent of a vertex
+     * @param index The vertex index
+     */
+    const vec3 &getTangent(int index) const
+    {
+        return tangents_[index];
+    }
+
+    /**
+     * @brief Get the bitangent handedness of a vertex (+1 or -1)
+     * @param index The vertex index
+     */
+    float getBitangentSign(int index) const
+    {
+        return bitangentSigns_[index];
+    }
+
+    size_t getMeshletCount() const
+    {
+        return meshlets_.size();
+    }
+
+    const Meshlet &getMeshlet(int index) const
+    {
+        return meshlets_[index];
+    }
+
+    /**
+     * @brief Global vertex index of a meshlet's local vertex
+     */
+    int getMeshletVertex(const Meshlet &meshlet, unsigned local) const
+    {
+        return meshletVertices_[meshlet.vertexOffset + local];
+    }
+
+    /**
+     * @brief Local vertex index of one corner of a meshlet triangle
+     */
+    unsigned getMeshletCorner(const Meshlet &meshlet, unsigned triangle, int corner) const
+    {
+        return meshletTriangles_[(meshlet.triangleOffset + triangle) * 3 + corner];
+    }
+
+    /**
+     * @brief Local vertex index of one end of a meshlet edge
+     */
+    unsigned getMeshletEdgeEnd(const Meshlet &meshlet, unsigned edge, int end) const
+    {
+        return meshletEdges_[(meshlet.edgeOffset + edge) * 2 + end];
+    }
+
+    /**
+     * @brief Unique edges not owned by any meshlet; draw these alongside the meshlet edges
+     */
+    const std::vector<std::pair<int, int>> &getLooseEdges() const
+    {
+        return looseEdges_;
+    }
+
+    /**
+     * @brief Global face index of a meshlet triangle
+     */
+    int getMeshletFace(const Meshlet &meshlet, unsigned triangle) const
+    {
+        return meshletFaces_[meshlet.triangleOffset + triangle];
+    }
+
+    /**
+     * @brief Get the minimum corner of the model's axis-aligned bounding box
+     * @return The smallest x, y and z over all vertices
+     */
+    const vec3 &getBoundsMin() const
+    {
+        return boundsMin_;
+    }
+
+    /**
+     * @brief Get the maximum corner of the model's axis-aligned bounding box
+     * @return The largest x, y and z over all vertices
+     */
+    const vec3 &getBoundsMax() const
+    {
+        return boundsMax_;
+    }
+
+    /**
+     * @brief Approximate heap memory held by the model
+     * @return Bytes reserved by the vertex, edge, face and attribute arrays
+     */
+    size_t getMemoryBytes() const
+    {
+        return (vertices_.capacity() + uvs_.capacity() + normals_.capacity() + tangents_.capacity()) * sizeof(vec3) +
+               edges_.capacity() * sizeof(std::pair<int, int>) + faces_.capacity() * sizeof(Face) +
+               bitangentSigns_.capacity() * sizeof(float) + meshlets_.capacity() * sizeof(Meshlet) +
+               (meshletVertices_.capacity() + meshletFaces_.capacity()) * sizeof(int) + meshletTriangles_.capacity() +
+               meshletEdges_.capacity() + (looseEdges_.capacity() + uniqueEdges_.capacity()) * sizeof(std::pair<int, int>);
+    }
 };
@@ -1,10 +1,12 @@
 #pragma once
 #include "model.h"
+#include "stats.h"
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <vector>
 #include <iostream>
+#include <stdexcept>
 
 /**
  * @brief A class for loading Wavefront OBJ files and converting them to Model objects
@@ -20,6 +22,8 @@ public:
      */
     static Model loadFromFile(const std::string &filename)
     {
+        STATS_SCOPED_TIMER(Load);
+
         std::ifstream file(filename);
         if (!file.is_open())
         {
@@ -28,6 +32,8 @@ public:
 
         Model model;
         std::vector<vec3> vertices;
+        size_t uvCount = 0;
+        size_t normalCount = 0;
         std::string line;
 
         while (std::getline(file, line))
@@ -42,26 +48,53 @@ public:
                 iss >> x >> y >> z;
                 vertices.push_back(vec3(x, y, z));
             }
+            else if (type == "vt")
+            { // Texture coordinate
+                float u = 0, v = 0;
+                iss >> u >> v;
+                model.addUV(vec3(u, v, 0));
+                uvCount++;
+            }
+            else if (type == "vn")
+            { // Normal
+                float x, y, z;
+                iss >> x >> y >> z;
+                model.addNormal(vec3(x, y, z));
+                normalCount++;
+            }
             else if (type == "f")
             { // Face
-                std::vector<int> faceIndices;
+                // Corners are "v", "v/vt", "v//vn" or "v/vt/vn"
+                std::vector<Corner> corners;
                 std::string vertex;
                 while (iss >> vertex)
                 {
-                    // OBJ indices are 1-based, convert to 0-based
-                    int idx = std::stoi(vertex) - 1;
-                    faceIndices.push_back(idx);
+                    corners.push_back(parseCorner(vertex));
                 }
 
                 // Create edges for the face (assuming triangular faces)
-                if (faceIndices.size() >= 3)
+                if (corners.size() >= 3)
                 {
-                    for (size_t i = 0; i < faceIndices.size(); i++)
+                    for (size_t i = 0; i < corners.size(); i++)
                     {
-                        int current = faceIndices[i];
-                        int next = faceIndices[(i + 1) % faceIndices.size()];
+                        int current = corners[i].vertex;
+                        int next = corners[(i + 1) % corners.size()].vertex;
                         model.addEdge(current, next);
                     }
+
+                    // Triangulate larger polygons as a fan around the first corner
+                    for (size_t i = 1; i + 1 < corners.size(); i++)
+                    {
+                        Face face;
+                        const Corner *fan[3] = {&corners[0], &corners[i], &corners[i + 1]};
+                        for (int k = 0; k < 3; k++)
+                        {
+                            face.vertex[k] = fan[k]->vertex;
+                            face.uv[k] = fan[k]->uv;
+                            face.normal[k] = fan[k]->normal;
+                        }
+                        model.addFace(face);
+                    }
                 }
             }
         }
@@ -72,6 +105,64 @@ public:
             model.addVertex(vertex);
         }
 
+        // Reject faces that point past the attribute arrays before anything indexes them
+        for (size_t i = 0; i < model.getFaceCount(); i++)
+        {
+            const Face &face = model.getFace(static_cast<int>(i));
+            for (int k = 0; k < 3; k++)
+            {
+                if (face.vertex[k] < 0 || face.vertex[k] >= static_cast<int>(model.getVertexCount()) ||
+                    face.uv[k] < -1 || face.uv[k] >= static_cast<int>(uvCount) ||
+                    face.normal[k] < -1 || face.normal[k] >= static_cast<int>(normalCount))
+                {
+                    throw std::runtime_error("Face index out of range in " + filename);
+                }
+            }
+        }
+
+        // Tangent frames are needed for normal mapping; build them once here
+        // rather than every time the model is shaded
+        model.computeTangents();
+
+        // Cluster faces so renderers can cull whole meshlets instead of every triangle
+        model.buildMeshlets();
+
         return model;
     }
+
+private:
+    /**
+     * @brief Attribute indices of one face corner, 0-based; -1 marks an absent uv or normal
+     */
+    struct Corner
+    {
+        int vertex;
+        int uv;
+        int normal;
+    };
+
+    /**
+     * @brief Split one face corner into 0-based attribute indices
+     * @param corner Text of the form "v", "v/vt", "v//vn" or "v/vt/vn" (1-based)
+     */
+    static Corner parseCorner(const std::string &corner)
+    {
+        // OBJ indices are 1-based, convert to 0-based
+        Corner result = {std::stoi(corner) - 1, -1, -1};
+        size_t slash = corner.find('/');
+        if (slash == std::string::npos)
+        {
+            return result;
+        }
+        size_t second = corner.find('/', slash + 1);
+        if (second != slash + 1 && slash + 1 < corner.size())
+        {
+            result.uv = std::stoi(corner.substr(slash + 1)) - 1;
+        }
+        if (second != std::string::npos && second + 1 < corner.size())
+        {
+            result.normal = std::stoi(corner.substr(second + 1)) - 1;
+        }
+        return result;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,338 @@
+#include "rasterizer.h"
+#include "stats.h"
+#include <algorithm>
+#include <cmath>
+
+void line(int startX, int startY, int endX, int endY, TGAImage &framebuffer, TGAColor color, int originY)
+{
+    const Rect window = {0, originY, framebuffer.width(), originY + framebuffer.height()};
+    line(startX, startY, endX, endY, framebuffer, color, window, originY);
+}
+
+namespace
+{
+/**
+ * @brief Visit the pixels of a transposed, left-to-right Bresenham line that fall in bounds
+ *
+ * Coordinates are along the major axis (x) and minor axis (y); for steep lines bounds must
+ * be transposed by the caller. Calls visit(x, y) for each pixel and returns their number.
+ */
+template <typename Visit>
+int walkLine(int startX, int startY, int endX, int endY, int majorMin, int majorMax, int minorMin, int minorMax,
+             Visit visit)
+{
+    const int dx = endX - startX;
+    const int dy = std::abs(endY - startY);
+    const int yStep = endY > startY ? 1 : -1;
+
+    // Restrict the major axis to the part of the line that lands in the bounds
+    const int first = std::max(startX, majorMin);
+    const int last = std::min(endX, majorMax - 1);
+    if (first > last || minorMin >= minorMax)
+    {
+        return 0;
+    }
+
+    // Bresenham keeps an integer error term instead of interpolating with floats.
+    // When the start is clipped, recover the error and minor coordinate after the skipped
+    // steps in closed form: the minor axis has advanced ceil((2*dy*k - dx) / (2*dx)) times.
+    // 64-bit arithmetic keeps this exact for gigapixel images.
+    const long long steps = first - startX;
+    const long long numerator = 2LL * dy * steps - dx;
+    const long long advanced = numerator > 0 ? (numerator + 2LL * dx - 1) / (2LL * dx) : 0;
+    long long error = 2LL * dy * steps - 2LL * dx * advanced;
+    int y = startY + yStep * static_cast<int>(advanced);
+    int visited = 0;
+
+    for (int x = first; x <= last; x++)
+    {
+        if (y >= minorMin && y < minorMax)
+        {
+            visit(x, y);
+            visited++;
+        }
+
+        error += 2 * dy;
+        if (error > dx)
+        {
+            y += yStep;
+            error -= 2 * dx;
+        }
+    }
+    return visited;
+}
+} // namespace
+
+void line(int startX, int startY, int endX, int endY, TGAImage &framebuffer, TGAColor color,
+          const Rect &clip, int originY)
+{
+    // Pixels may only land where the clip rectangle overlaps the framebuffer window
+    const Rect window = {0, originY, framebuffer.width(), originY + framebuffer.height()};
+    const Rect bounds = clip.intersect(window);
+
+    // A line drawn into several windows (bands) is counted once, by the window holding
+    // its topmost row inside the clip rectangle, so the totals match a full-frame render
+    const int homeRow = std::clamp(std::min(startY, endY), clip.y0, std::max(clip.y0, clip.y1 - 1));
+    const bool counted = homeRow >= window.y0 && homeRow < window.y1;
+
+    // Check if the line is steep (more vertical than horizontal).
+    // Steep lines are transposed so we always step along the axis of greatest change,
+    // which guarantees one pixel per step and no gaps.
+    bool steep = std::abs(endY - startY) > std::abs(endX - startX);
+    if (steep)
+    {
+        std::swap(startX, startY);
+        std::swap(endX, endY);
+    }
+    // Always iterate from left to right
+    if (startX > endX)
+    {
+        std::swap(startX, endX);
+        std::swap(startY, endY);
+    }
+
+    // Undo the transpose for steep lines and shift into the framebuffer window
+    const int written = walkLine(startX, startY, endX, endY,
+                                 steep ? bounds.y0 : bounds.x0, steep ? bounds.y1 : bounds.x1,
+                                 steep ? bounds.x0 : bounds.y0, steep ? bounds.x1 : bounds.y1,
+                                 [&](int x, int y)
+                                 {
+                                     if (steep)
+                                     {
+                                         framebuffer.set(y, x - originY, color);
+                                     }
+                                     else
+                                     {
+                                         framebuffer.set(x, y - originY, color);
+                                     }
+                                 });
+    STATS_ADD(PixelsWritten, written);
+
+    if constexpr (stats::enabled())
+    {
+        if (counted)
+        {
+            // Clipping to the window is not clipping: only pixels outside clip count
+            const int visible = bounds.y0 == clip.y0 && bounds.y1 == clip.y1 && bounds.x0 == clip.x0 && bounds.x1 == clip.x1
+                                    ? written
+                                    : walkLine(startX, startY, endX, endY,
+                                               steep ? clip.y0 : clip.x0, steep ? clip.y1 : clip.x1,
+                                               steep ? clip.x0 : clip.y0, steep ? clip.x1 : clip.y1,
+                                               [](int, int) {});
+            STATS_ADD(LinesDrawn, visible > 0 ? 1 : 0);
+            STATS_ADD(PixelsClipped, endX - startX + 1 - visible);
+        }
+    }
+}
+
+void blendPixel(TGAImage &framebuffer, int x, int y, TGAColor color, float coverage)
+{
+    if (coverage >= 1.0f)
+    {
+        framebuffer.set(x, y, color);
+        return;
+    }
+    if (x < 0 || y < 0 || x >= framebuffer.width() || y >= framebuffer.height())
+    {
+        return;
+    }
+    // Blend in place rather than round-tripping through get() and set()
+    const int bpp = framebuffer.bytes_per_pixel();
+    std::uint8_t *pixel = framebuffer.buffer() + (x + static_cast<size_t>(y) * framebuffer.width()) * bpp;
+    for (int c = 0; c < bpp; c++)
+    {
+        pixel[c] = static_cast<std::uint8_t>(pixel[c] + (color[c] - pixel[c]) * coverage + 0.5f);
+    }
+}
+
+void lineAA(float startX, float startY, float endX, float endY, TGAImage &framebuffer, TGAColor color)
+{
+    // Wu's algorithm puts pixel centers on integer coordinates
+    startX -= 0.5f;
+    startY -= 0.5f;
+    endX -= 0.5f;
+    endY -= 0.5f;
+
+    // Step along the axis of greatest change, left to right, as line() does
+    const bool steep = std::abs(endY - startY) > std::abs(endX - startX);
+    if (steep)
+    {
+        std::swap(startX, startY);
+        std::swap(endX, endY);
+    }
+    if (startX > endX)
+    {
+        std::swap(startX, endX);
+        std::swap(startY, endY);
+    }
+    const float dx = endX - startX;
+    const float gradient = dx > 0.0f ? (endY - startY) / dx : 0.0f;
+
+    // Only the columns inside the image are visited; rows outside it are skipped by blendPixel.
+    // toPixel() keeps far off-screen ends of a deep zoom within range of int
+    const int majorSize = steep ? framebuffer.height() : framebuffer.width();
+    const int first = std::max(0, toPixel(std::floor(startX + 0.5f)));
+    const int last = std::min(majorSize - 1, toPixel(std::floor(endX + 0.5f)));
+    int written = 0;
+
+    for (int x = first; x <= last; x++)
+    {
+        // Share of this column the line spans; below 1 only at the end pixels
+        const float span = std::min(endX, x + 0.5f) - std::max(startX, x - 0.5f);
+        const float coverage = std::clamp(span, 0.0f, 1.0f);
+        if (coverage <= 0.0f)
+        {
+            continue;
+        }
+
+        // Split the column's coverage between the two pixels around the line
+        const float y = startY + gradient * (x - startX);
+        const int below = toPixel(std::floor(y));
+        const float fraction = y - below;
+        if (steep)
+        {
+            blendPixel(framebuffer, below, x, color, coverage * (1.0f - fraction));
+            blendPixel(framebuffer, below + 1, x, color, coverage * fraction);
+        }
+        else
+        {
+            blendPixel(framebuffer, x, below, color, coverage * (1.0f - fraction));
+            blendPixel(framebuffer, x, below + 1, color, coverage * fraction);
+        }
+        written += 2;
+    }
+
+    STATS_ADD(LinesDrawn, 1);
+    STATS_ADD(PixelsWritten, written);
+}
+
+void projectVertices(const Model &model, const View &view, int width, int height,
+                     std::vector<int> &screenX, std::vector<int> &screenY)
+{
+    STATS_SCOPED_TIMER(Projection);
+    const size_t vertexCount = model.getVertexCount();
+    screenX.resize(vertexCount);
+    screenY.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const vec3 &v = model.getVertex(static_cast<int>(i));
+        screenX[i] = toPixel(toScreenPosition(v.x, view.centerX, view.zoom, width));
+        screenY[i] = toPixel(toScreenPosition(v.y, view.centerY, view.zoom, height));
+    }
+}
+
+void projectVertices(const Model &model, const Transform &transform, const View &view, int width, int height,
+                     std::vector<int> &screenX, std::vector<int> &screenY)
+{
+    STATS_SCOPED_TIMER(Projection);
+    const size_t vertexCount = model.getVertexCount();
+    screenX.resize(vertexCount);
+    screenY.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const vec3 v = transform.apply(model.getVertex(static_cast<int>(i)));
+        screenX[i] = toPixel(toScreenPosition(v.x, view.centerX, view.zoom, width));
+        screenY[i] = toPixel(toScreenPosition(v.y, view.centerY, view.zoom, height));
+    }
+}
+
+bool isMeshletOnScreen(const Meshlet &meshlet, const View &view, int width, int height)
+{
+    const float centerX = toScreenPosition(meshlet.center.x, view.centerX, view.zoom, width);
+    const float centerY = toScreenPosition(meshlet.center.y, view.centerY, view.zoom, height);
+    const float radiusX = meshlet.radius * std::abs(view.zoom) * width / 2.0f + 1.0f;
+    const float radiusY = meshlet.radius * std::abs(view.zoom) * height / 2.0f + 1.0f;
+    return centerX + radiusX >= 0.0f && centerX - radiusX <= width &&
+           centerY + radiusY >= 0.0f && centerY - radiusY <= height;
+}
+
+void drawWireframe(const Model &model, const View &view, TGAImage &framebuffer, TGAColor color, bool antialias)
+{
+    const int width = framebuffer.width();
+    const int height = framebuffer.height();
+    auto toScreenX = [&](float x)
+    { return toScreenPosition(x, view.centerX, view.zoom, width); };
+    auto toScreenY = [&](float y)
+    { return toScreenPosition(y, view.centerY, view.zoom, height); };
+
+    // Draw one edge between projected positions; antialiased lines keep sub-pixel precision
+    auto drawEdge = [&](float x0, float y0, float x1, float y1)
+    {
+        if (antialias)
+        {
+            lineAA(x0, y0, x1, y1, framebuffer, color);
+        }
+        else
+        {
+            line(toPixel(x0), toPixel(y0), toPixel(x1), toPixel(y1), framebuffer, color);
+        }
+    };
+
+    if (model.getMeshletCount() == 0)
+    {
+        // Without meshlets every vertex is projected and every edge drawn
+        std::vector<float> positions(model.getVertexCount() * 2);
+        {
+            STATS_SCOPED_TIMER(Projection);
+            for (size_t i = 0; i < model.getVertexCount(); i++)
+            {
+                const vec3 &v = model.getVertex(static_cast<int>(i));
+                positions[2 * i] = toScreenX(v.x);
+                positions[2 * i + 1] = toScreenY(v.y);
+            }
+        }
+
+        STATS_SCOPED_TIMER(Rasterization);
+        for (const auto &edge : model.getUniqueEdges())
+        {
+            drawEdge(positions[2 * edge.first], positions[2 * edge.first + 1],
+                     positions[2 * edge.second], positions[2 * edge.second + 1]);
+        }
+        return;
+    }
+
+    // Cull whole clusters, then project only the vertices of the survivors
+    std::vector<const Meshlet *> visible;
+    std::vector<float> positions;
+    std::vector<size_t> firstPosition;
+    {
+        STATS_SCOPED_TIMER(Projection);
+        for (size_t i = 0; i < model.getMeshletCount(); i++)
+        {
+            const Meshlet &meshlet = model.getMeshlet(static_cast<int>(i));
+            if (!isMeshletOnScreen(meshlet, view, width, height))
+            {
+                STATS_ADD(MeshletsCulled, 1);
+                continue;
+            }
+            STATS_ADD(MeshletsDrawn, 1);
+            visible.push_back(&meshlet);
+            firstPosition.push_back(positions.size());
+            for (unsigned v = 0; v < meshlet.vertexCount; v++)
+            {
+                const vec3 &p = model.getVertex(model.getMeshletVertex(meshlet, v));
+                positions.push_back(toScreenX(p.x));
+                positions.push_back(toScreenY(p.y));
+            }
+        }
+    }
+
+    STATS_SCOPED_TIMER(Rasterization);
+    for (size_t i = 0; i < visible.size(); i++)
+    {
+        const Meshlet &meshlet = *visible[i];
+        const float *local = positions.data() + firstPosition[i];
+        for (unsigned e = 0; e < meshlet.edgeCount; e++)
+        {
+            const unsigned a = model.getMeshletEdgeEnd(meshlet, e, 0);
+            const unsigned b = model.getMeshletEdgeEnd(meshlet, e, 1);
+            drawEdge(local[2 * a], local[2 * a + 1], local[2 * b], local[2 * b + 1]);
+        }
+    }
+    for (const auto &edge : model.getLooseEdges())
+    {
+        const vec3 &p = model.getVertex(edge.first);
+        const vec3 &q = model.getVertex(edge.second);
+        drawEdge(toScreenX(p.x), toScreenY(p.y), toScreenX(q.x), toScreenY(q.y));
+    }
+}
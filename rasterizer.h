@@ -0,0 +1,216 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "model.h"
+#include "tgaimage.h"
+
+/**
+ * @brief 2D camera for the orthographic projection
+ *
+ * The point (centerX, centerY) lands in the middle of the image and model units are
+ * scaled by zoom, so the default view maps [-1, 1] onto the whole image.
+ */
+struct View
+{
+    float centerX = 0.0f; // Model-space point shown at the image center
+    float centerY = 0.0f;
+    float zoom = 1.0f;    // Magnification; 2 shows half the model-space extent
+
+    /**
+     * @brief Whether the view can be projected: finite center and a finite, positive zoom
+     */
+    bool valid() const
+    {
+        return std::isfinite(centerX) && std::isfinite(centerY) && std::isfinite(zoom) && zoom > 0.0f;
+    }
+};
+
+/**
+ * @brief Axis-aligned pixel rectangle covering columns [x0, x1) and rows [y0, y1)
+ */
+struct Rect
+{
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = 0;
+    int y1 = 0;
+
+    bool empty() const
+    {
+        return x0 >= x1 || y0 >= y1;
+    }
+
+    long long area() const
+    {
+        return empty() ? 0 : static_cast<long long>(x1 - x0) * (y1 - y0);
+    }
+
+    /**
+     * @brief The overlap of two rectangles, possibly empty
+     */
+    Rect intersect(const Rect &r) const
+    {
+        return {std::max(x0, r.x0), std::max(y0, r.y0), std::min(x1, r.x1), std::min(y1, r.y1)};
+    }
+
+    /**
+     * @brief The smallest rectangle containing both; empty rectangles are ignored
+     */
+    Rect unite(const Rect &r) const
+    {
+        if (empty())
+        {
+            return r;
+        }
+        if (r.empty())
+        {
+            return *this;
+        }
+        return {std::min(x0, r.x0), std::min(y0, r.y0), std::max(x1, r.x1), std::max(y1, r.y1)};
+    }
+};
+
+/**
+ * @brief Largest distance from the origin, in pixels, of an integer screen coordinate
+ *
+ * Far beyond any image yet small enough that line() can subtract two coordinates and
+ * double the result without overflowing an int.
+ */
+constexpr int MaxScreenCoordinate = 1 << 28;
+
+/**
+ * @brief Convert a pixel position to an integer pixel coordinate
+ *
+ * Positions far off-screen, and non-finite ones, are clamped to MaxScreenCoordinate so
+ * the conversion is always defined.
+ */
+inline int toPixel(float position)
+{
+    constexpr float limit = static_cast<float>(MaxScreenCoordinate);
+    return static_cast<int>(position > -limit ? std::min(position, limit) : -limit);
+}
+
+/**
+ * @brief Map a model-space coordinate to a sub-pixel screen position
+ *
+ * The orthographic projection used by every renderer: center lands in the middle of the
+ * image and zoom scales model units, so [-1, 1] covers the image at zoom 1. Pixel i spans
+ * [i, i + 1).
+ *
+ * @param coordinate Model-space x or y
+ * @param center View center on the same axis
+ * @param zoom View magnification
+ * @param size Width or height of the image in pixels
+ * @return The screen position in pixels
+ */
+inline float toScreenPosition(float coordinate, float center, float zoom, int size)
+{
+    return ((coordinate - center) * zoom + 1.0f) * size / 2.0f;
+}
+
+/**
+ * @brief Map a normalized device coordinate to a pixel coordinate
+ *
+ * Simple orthographic viewport transform: -1 maps to the first pixel, +1 to size.
+ *
+ * @param ndc Coordinate in the range [-1, 1]
+ * @param size Width or height of the image in pixels
+ * @return The pixel coordinate, clamped as by toPixel()
+ */
+inline int toScreen(float ndc, int size)
+{
+    return toPixel(toScreenPosition(ndc, 0.0f, 1.0f, size));
+}
+
+/**
+ * @brief Draw a line between two pixel positions using Bresenham's algorithm
+ *
+ * Coordinates are in full-image space. The framebuffer may be a window onto a taller
+ * image: originY is the image row stored in framebuffer row 0. Pixels outside the window
+ * are skipped without changing which pixels are lit inside it, so a band renders exactly
+ * the rows a full-frame render would.
+ *
+ * @param startX X coordinate of the first endpoint
+ * @param startY Y coordinate of the first endpoint
+ * @param endX X coordinate of the second endpoint
+ * @param endY Y coordinate of the second endpoint
+ * @param framebuffer Image (or band of an image) to draw into
+ * @param color Color of the line
+ * @param originY Image row that maps to framebuffer row 0
+ */
+void line(int startX, int startY, int endX, int endY, TGAImage &framebuffer, TGAColor color, int originY = 0);
+
+/**
+ * @brief Draw only the part of a line inside a clip rectangle
+ *
+ * Lights exactly the pixels of the unclipped line that fall inside clip, so redrawing
+ * a region with a clip rectangle matches a full redraw pixel for pixel.
+ *
+ * @param clip Rectangle in image coordinates; it is further limited to the framebuffer window
+ */
+void line(int startX, int startY, int endX, int endY, TGAImage &framebuffer, TGAColor color,
+          const Rect &clip, int originY = 0);
+
+/**
+ * @brief Mix a color into one pixel in proportion to how much of the pixel it covers
+ *
+ * Pixels outside the framebuffer are ignored.
+ *
+ * @param coverage Fraction of the pixel covered, in [0, 1]; 1 overwrites the pixel
+ */
+void blendPixel(TGAImage &framebuffer, int x, int y, TGAColor color, float coverage);
+
+/**
+ * @brief Draw an antialiased line with Xiaolin Wu's algorithm
+ *
+ * Endpoints are continuous image coordinates: pixel (i, j) spans [i, i + 1) x [j, j + 1).
+ * Each step along the major axis splits the color between the two pixels straddling
+ * the line, weighted by their distance to it, and the end pixels are weighted by how
+ * far the line extends into them. Coverage is computed in a single pass at the target
+ * resolution, so no supersampled framebuffer is needed.
+ *
+ * @param framebuffer Image to blend into
+ * @param color Color of the line at full coverage
+ */
+void lineAA(float startX, float startY, float endX, float endY, TGAImage &framebuffer, TGAColor color);
+
+/**
+ * @brief Project every vertex of a model to pixel coordinates
+ * @param model The model to project
+ * @param view Camera used for the projection
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param screenX Receives the pixel column of each vertex
+ * @param screenY Receives the pixel row of each vertex
+ */
+void projectVertices(const Model &model, const View &view, int width, int height,
+                     std::vector<int> &screenX, std::vector<int> &screenY);
+
+/**
+ * @brief Project every vertex of a placed model to pixel coordinates
+ * @param transform Placement of the model in the scene, applied before the view
+ */
+void projectVertices(const Model &model, const Transform &transform, const View &view, int width, int height,
+                     std::vector<int> &screenX, std::vector<int> &screenY);
+
+/**
+ * @brief Whether a meshlet's bounding sphere can reach the viewport
+ *
+ * Conservative by one pixel, so lines that round onto the border are never culled.
+ */
+bool isMeshletOnScreen(const Meshlet &meshlet, const View &view, int width, int height);
+
+/**
+ * @brief Draw every edge of a model into a full framebuffer
+ *
+ * When the model has meshlets, clusters whose bounding sphere misses the viewport are
+ * skipped before their vertices are projected, and edges shared by several faces are
+ * drawn once.
+ * @param model The model to draw
+ * @param view Camera used for the projection
+ * @param framebuffer Image to draw into; its size defines the viewport
+ * @param color Color of the edges
+ * @param antialias Draw edges with lineAA() from sub-pixel positions instead of line()
+ */
+void drawWireframe(const Model &model, const View &view, TGAImage &framebuffer, TGAColor color, bool antialias = false);
@@ -0,0 +1,394 @@
+#include "render_service.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include "obj_loader.h"
+#include "stats.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define RENDERER_HAS_UNIX_SOCKETS 1
+// A client hanging up mid-response must not kill the service with SIGPIPE
+#ifdef MSG_NOSIGNAL
+constexpr int sendFlags = MSG_NOSIGNAL;
+#else
+constexpr int sendFlags = 0;
+#endif
+#endif
+
+namespace
+{
+constexpr TGAColor white = {{255, 255, 255, 255}};
+
+bool isQuit(const std::string &line)
+{
+    return line == "quit" || line == "quit\r";
+}
+
+#ifdef RENDERER_HAS_UNIX_SOCKETS
+/**
+ * @brief Send all of data, retrying after partial writes and interrupts
+ * @return false if the client went away
+ */
+bool sendAll(int socket, const std::string &data)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        const ssize_t result = send(socket, data.data() + sent, data.size() - sent, sendFlags);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            return false;
+        }
+        sent += static_cast<size_t>(result);
+    }
+    return true;
+}
+#endif
+} // namespace
+
+RenderJob parseRenderJob(const std::string &line)
+{
+    RenderJob job;
+    std::istringstream fields(line);
+    std::string field;
+    while (fields >> field)
+    {
+        size_t eq = field.find('=');
+        if (eq == std::string::npos)
+        {
+            throw std::runtime_error("Expected key=value, got: " + field);
+        }
+        std::string key = field.substr(0, eq);
+        std::string value = field.substr(eq + 1);
+
+        if (key == "model")
+        {
+            job.modelPath = value;
+        }
+        else if (key == "out")
+        {
+            job.outputPath = value;
+        }
+        else if (key == "size")
+        {
+            if (std::sscanf(value.c_str(), "%dx%d", &job.width, &job.height) != 2 ||
+                job.width <= 0 || job.height <= 0 ||
+                job.width > TGAImage::max_dimension || job.height > TGAImage::max_dimension)
+            {
+                throw std::runtime_error("Invalid size: " + value);
+            }
+        }
+        else if (key == "shade")
+        {
+            job.shade = value == "1" || value == "true";
+        }
+        else if (key == "aa")
+        {
+            job.antialias = value == "1" || value == "true";
+        }
+        else if (key == "view")
+        {
+            if (std::sscanf(value.c_str(), "%f,%f,%f", &job.view.centerX, &job.view.centerY, &job.view.zoom) != 3 ||
+                !job.view.valid())
+            {
+                throw std::runtime_error("Invalid view: " + value);
+            }
+        }
+        else
+        {
+            throw std::runtime_error("Unknown job field: " + key);
+        }
+    }
+    if (job.modelPath.empty() || job.outputPath.empty())
+    {
+        throw std::runtime_error("Job needs both model= and out=");
+    }
+    return job;
+}
+
+TGAImage FramebufferPool::acquire(int width, int height, int bpp)
+{
+    for (size_t i = 0; i < idle_.size(); i++)
+    {
+        TGAImage &candidate = idle_[i];
+        if (candidate.width() == width && candidate.height() == height && candidate.bytes_per_pixel() == bpp)
+        {
+            TGAImage framebuffer = std::move(candidate);
+            idle_.erase(idle_.begin() + i);
+            sizeBytes_ -= static_cast<size_t>(width) * height * bpp;
+            framebuffer.clear();
+            return framebuffer;
+        }
+    }
+    return TGAImage(width, height, bpp);
+}
+
+void FramebufferPool::release(TGAImage &&framebuffer)
+{
+    const size_t bytes = static_cast<size_t>(framebuffer.width()) * framebuffer.height() * framebuffer.bytes_per_pixel();
+    if (bytes > capacityBytes_)
+    {
+        return;
+    }
+    // Drop the oldest idle framebuffers to make room
+    while (sizeBytes_ + bytes > capacityBytes_)
+    {
+        const TGAImage &oldest = idle_.front();
+        sizeBytes_ -= static_cast<size_t>(oldest.width()) * oldest.height() * oldest.bytes_per_pixel();
+        idle_.erase(idle_.begin());
+    }
+    idle_.push_back(std::move(framebuffer));
+    sizeBytes_ += bytes;
+}
+
+DeferredRenderer VisibilityBufferPool::acquire(int width, int height)
+{
+    for (size_t i = 0; i < idle_.size(); i++)
+    {
+        if (idle_[i].getWidth() == width && idle_[i].getHeight() == height)
+        {
+            DeferredRenderer renderer = std::move(idle_[i]);
+            idle_.erase(idle_.begin() + i);
+            sizeBytes_ -= renderer.getMemoryBytes();
+            return renderer;
+        }
+    }
+    return DeferredRenderer(width, height);
+}
+
+void VisibilityBufferPool::release(DeferredRenderer &&renderer)
+{
+    const size_t bytes = renderer.getMemoryBytes();
+    if (bytes > capacityBytes_)
+    {
+        return;
+    }
+    // Drop the oldest idle buffers to make room
+    while (sizeBytes_ + bytes > capacityBytes_)
+    {
+        sizeBytes_ -= idle_.front().getMemoryBytes();
+        idle_.erase(idle_.begin());
+    }
+    idle_.push_back(std::move(renderer));
+    sizeBytes_ += bytes;
+}
+
+RenderService::RenderService(const ServiceConfig &config)
+    : models_(config.modelCacheBytes),
+      textures_(config.textureCacheBytes),
+      framebuffers_(config.framebufferPoolBytes),
+      visibilityBuffers_(config.visibilityPoolBytes),
+      maxJobBytes_(config.maxJobBytes),
+      reportStats_(config.reportStats)
+{
+}
+
+std::shared_ptr<const Model> RenderService::getModel(const std::string &path)
+{
+    if (auto cached = models_.get(path))
+    {
+        return cached;
+    }
+    auto model = std::make_shared<const Model>(OBJLoader::loadFromFile(path));
+    models_.put(path, model, model->getMemoryBytes());
+    return model;
+}
+
+std::shared_ptr<const TGAImage> RenderService::getTexture(const std::string &path)
+{
+    if (auto cached = textures_.get(path))
+    {
+        return cached;
+    }
+    auto texture = std::make_shared<TGAImage>();
+    if (!texture->read_tga_file(path))
+    {
+        throw std::runtime_error("Failed to read texture: " + path);
+    }
+    const size_t bytes = static_cast<size_t>(texture->width()) * texture->height() * texture->bytes_per_pixel();
+    textures_.put(path, texture, bytes);
+    return texture;
+}
+
+std::string RenderService::handle(const std::string &line)
+{
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        RenderJob job = parseRenderJob(line);
+        stats::reset();
+
+        // Refuse oversized jobs before allocating anything for them
+        const size_t pixels = static_cast<size_t>(job.width) * job.height;
+        const size_t jobBytes = pixels * TGAImage::RGB + (job.shade ? pixels * DeferredRenderer::BytesPerPixel : 0);
+        if (jobBytes > maxJobBytes_)
+        {
+            return "error job needs " + std::to_string(jobBytes) + " bytes of buffers, limit is " +
+                   std::to_string(maxJobBytes_);
+        }
+
+        const size_t missesBefore = models_.getMisses();
+        std::shared_ptr<const Model> model = getModel(job.modelPath);
+        const bool modelHit = models_.getMisses() == missesBefore;
+
+        TGAImage framebuffer = framebuffers_.acquire(job.width, job.height, TGAImage::RGB);
+        if (job.shade)
+        {
+            // Textures come from the cache too; a missing map just disables that term
+            Material material;
+            auto optionalTexture = [&](const std::string &suffix) -> std::shared_ptr<const TGAImage>
+            {
+                const std::string path = texturePath(job.modelPath, suffix);
+                return std::filesystem::exists(path) ? getTexture(path) : nullptr;
+            };
+            material.diffuse = optionalTexture("_diffuse");
+            material.normal = optionalTexture("_nm_tangent");
+            material.specular = optionalTexture("_spec");
+
+            DeferredRenderer renderer = visibilityBuffers_.acquire(job.width, job.height);
+            renderer.rasterize(*model, job.view, job.antialias);
+            renderer.shade(*model, material, vec3(1, 1, 1), framebuffer);
+            visibilityBuffers_.release(std::move(renderer));
+        }
+        else
+        {
+            drawWireframe(*model, job.view, framebuffer, white, job.antialias);
+        }
+        const bool written = framebuffer.write_tga_file(job.outputPath);
+        framebuffers_.release(std::move(framebuffer));
+        if (!written)
+        {
+            return "error failed to write " + job.outputPath;
+        }
+
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        std::ostringstream response;
+        response << "ok out=" << job.outputPath
+                 << " ms=" << elapsed.count()
+                 << " model_cache=" << (modelHit ? "hit" : "miss");
+        if (reportStats_)
+        {
+            // Only this job's work: the counters were reset when it started
+            std::ostringstream json;
+            stats::writeJson(json);
+            std::string text = json.str();
+            text.erase(text.find_last_not_of('\n') + 1);
+            response << " stats=" << text;
+        }
+        return response.str();
+    }
+    catch (const std::exception &e)
+    {
+        return std::string("error ") + e.what();
+    }
+}
+
+void RenderService::serve(std::istream &in, std::ostream &out)
+{
+    std::string line;
+    while (std::getline(in, line) && !isQuit(line))
+    {
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+        out << handle(line) << std::endl;
+    }
+}
+
+bool RenderService::serveSocket(const std::string &path)
+{
+#ifdef RENDERER_HAS_UNIX_SOCKETS
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "socket path too long: " << path << std::endl;
+        return false;
+    }
+    path.copy(address.sun_path, path.size());
+
+    // A socket left behind by a previous run would make bind fail
+    std::error_code ec;
+    if (std::filesystem::is_socket(path, ec))
+    {
+        std::filesystem::remove(path, ec);
+    }
+
+    // Jobs write files with this user's permissions, so only this user may connect.
+    // The socket is created owner-only under a tight umask so there is no window in
+    // which another user could connect; chmod makes the mode explicit.
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    bool bound = false;
+    if (listener >= 0)
+    {
+        const mode_t previousMask = umask(0077);
+        bound = bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+        umask(previousMask);
+    }
+    if (!bound || chmod(path.c_str(), 0600) < 0 || listen(listener, 8) < 0)
+    {
+        std::perror("render service socket");
+        if (listener >= 0)
+        {
+            close(listener);
+        }
+        return false;
+    }
+
+    bool quit = false;
+    while (!quit)
+    {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0)
+        {
+            continue;
+        }
+
+        // Split the byte stream into job lines and answer each one
+        std::string pending;
+        char buffer[4096];
+        ssize_t received;
+        bool connected = true;
+        while (!quit && connected && (received = recv(client, buffer, sizeof(buffer), 0)) > 0)
+        {
+            pending.append(buffer, received);
+            size_t newline;
+            while (!quit && connected && (newline = pending.find('\n')) != std::string::npos)
+            {
+                std::string line = pending.substr(0, newline);
+                pending.erase(0, newline + 1);
+                if (isQuit(line))
+                {
+                    quit = true;
+                }
+                else if (!line.empty() && line[0] != '#')
+                {
+                    connected = sendAll(client, handle(line) + "\n");
+                }
+            }
+        }
+        close(client);
+    }
+
+    close(listener);
+    std::filesystem::remove(path, ec);
+    return true;
+#else
+    std::cerr << "Unix sockets are not supported on this platform" << std::endl;
+    return false;
+#endif
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+#include "deferred_renderer.h"
+#include "lru_cache.h"
+#include "model.h"
+#include "rasterizer.h"
+#include "tgaimage.h"
+
+/**
+ * @brief One render request handled by the resident service
+ */
+struct RenderJob
+{
+    std::string modelPath;  // OBJ file to draw
+    std::string outputPath; // TGA file to write
+    View view;              // Camera for the projection
+    int width = 800;        // Output width in pixels
+    int height = 800;       // Output height in pixels
+    bool shade = false;     // Shade textured triangles instead of drawing the wireframe
+    bool antialias = false; // Smooth lines or triangle silhouettes
+};
+
+/**
+ * @brief Parse a job line of whitespace separated key=value fields
+ *
+ * Example: model=obj/floor.obj out=floor.tga size=1024x768 view=0,0.5,2
+ * model and out are required; size defaults to 800x800 and view to 0,0,1.
+ * Sizes are limited to what a TGA file can store and the zoom must be finite and positive.
+ * shade=1 renders with the model's textures through the visibility-buffer path.
+ * aa=1 antialiases the wireframe or the shaded silhouettes.
+ *
+ * @param line The job description
+ * @return The parsed job
+ * @throws std::runtime_error if a field is unknown, malformed or missing
+ */
+RenderJob parseRenderJob(const std::string &line);
+
+/**
+ * @brief Recycles framebuffers between jobs instead of reallocating them
+ */
+class FramebufferPool
+{
+public:
+    /**
+     * @brief Construct a pool
+     * @param capacityBytes Total size of idle framebuffers kept for reuse
+     */
+    explicit FramebufferPool(size_t capacityBytes) : capacityBytes_(capacityBytes) {}
+
+    /**
+     * @brief Take a cleared framebuffer of the given shape, reusing an idle one when possible
+     */
+    TGAImage acquire(int width, int height, int bpp);
+
+    /**
+     * @brief Return a framebuffer to the pool; it is dropped if the pool is full
+     */
+    void release(TGAImage &&framebuffer);
+
+private:
+    size_t capacityBytes_;
+    size_t sizeBytes_ = 0;
+    std::vector<TGAImage> idle_;
+};
+
+/**
+ * @brief Keeps visibility buffers of recent resolutions for reuse, within a byte budget
+ */
+class VisibilityBufferPool
+{
+public:
+    /**
+     * @brief Construct a pool
+     * @param capacityBytes Total size of idle visibility buffers kept for reuse
+     */
+    explicit VisibilityBufferPool(size_t capacityBytes) : capacityBytes_(capacityBytes) {}
+
+    /**
+     * @brief Take a renderer of the given size, reusing an idle one when possible
+     */
+    DeferredRenderer acquire(int width, int height);
+
+    /**
+     * @brief Return a renderer to the pool; it is dropped if the pool is full
+     */
+    void release(DeferredRenderer &&renderer);
+
+private:
+    size_t capacityBytes_;
+    size_t sizeBytes_ = 0;
+    std::vector<DeferredRenderer> idle_;
+};
+
+/**
+ * @brief Settings for the resident render service
+ */
+struct ServiceConfig
+{
+    size_t modelCacheBytes = 256u << 20;      // Budget for parsed models
+    size_t textureCacheBytes = 256u << 20;    // Budget for decoded textures
+    size_t framebufferPoolBytes = 64u << 20;  // Budget for idle framebuffers
+    size_t visibilityPoolBytes = 64u << 20;   // Budget for idle visibility buffers
+    size_t maxJobBytes = 1u << 30;            // Largest framebuffer plus visibility buffer one job may allocate
+    bool reportStats = false;                 // Append each job's stats as JSON to its response
+};
+
+/**
+ * @brief Long-running headless renderer that keeps assets resident between jobs
+ *
+ * Each job names a model, view, resolution and output path. Parsed models and decoded
+ * textures stay in size-bounded LRU caches and framebuffers come from a pool, so repeated
+ * jobs against the same assets skip all load and allocation cost.
+ *
+ * Jobs arrive one per line, from a stream or a local Unix socket, and each gets a
+ * one-line response: "ok ..." with timing and cache status, or "error <message>".
+ * Stats are reset at the start of every job, so each response can report that job alone.
+ * A line containing only "quit" stops the service.
+ */
+class RenderService
+{
+public:
+    explicit RenderService(const ServiceConfig &config = ServiceConfig());
+
+    /**
+     * @brief Run one job line and describe the outcome
+     * @param line The job description (see parseRenderJob)
+     * @return The response line, without a trailing newline
+     */
+    std::string handle(const std::string &line);
+
+    /**
+     * @brief Serve jobs read from a stream until end of input or "quit"
+     */
+    void serve(std::istream &in, std::ostream &out);
+
+    /**
+     * @brief Serve jobs from clients of a Unix domain socket, one connection at a time
+     * @param path Filesystem path of the socket
+     * @return false if the socket could not be created; true once a client sends "quit"
+     */
+    bool serveSocket(const std::string &path);
+
+    /**
+     * @brief Get a model, loading and caching it on a miss
+     * @throws std::runtime_error if the file cannot be loaded
+     */
+    std::shared_ptr<const Model> getModel(const std::string &path);
+
+    /**
+     * @brief Get a decoded texture, loading and caching it on a miss
+     * @throws std::runtime_error if the file cannot be decoded
+     */
+    std::shared_ptr<const TGAImage> getTexture(const std::string &path);
+
+private:
+    LRUCache<Model> models_;
+    LRUCache<TGAImage> textures_;
+    FramebufferPool framebuffers_;
+    VisibilityBufferPool visibilityBuffers_;
+    size_t maxJobBytes_;
+    bool reportStats_;
+};
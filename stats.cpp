@@ -0,0 +1,51 @@
+#include "stats.h"
+#include <iomanip>
+#include <ostream>
+
+namespace stats
+{
+StageTotals stageTotals[static_cast<int>(Stage::Count)];
+std::uint64_t counters[static_cast<int>(Counter::Count)];
+
+static const char *const stageNames[] = {"load", "projection", "rasterization", "shading", "encode", "write"};
+static const char *const counterNames[] = {"lines_drawn", "pixels_written", "pixels_clipped", "bytes_raw", "bytes_encoded",
+                                             "instances_drawn", "instances_culled", "pixels_redrawn",
+                                             "fragments_tested", "pixels_shaded", "meshlets_drawn", "meshlets_culled"};
+
+void reset()
+{
+    for (StageTotals &totals : stageTotals)
+    {
+        totals = {};
+    }
+    for (std::uint64_t &counter : counters)
+    {
+        counter = 0;
+    }
+}
+
+void writeJson(std::ostream &out)
+{
+    out << "{\"enabled\": " << (enabled() ? "true" : "false");
+
+    out << ", \"stages\": {";
+    for (int i = 0; i < static_cast<int>(Stage::Count); i++)
+    {
+        out << (i ? ", " : "") << "\"" << stageNames[i] << "\": {\"calls\": " << stageTotals[i].calls
+            << ", \"ms\": " << std::fixed << std::setprecision(3) << stageTotals[i].nanoseconds / 1e6 << "}";
+    }
+    out << "}";
+
+    out << ", \"counters\": {";
+    for (int i = 0; i < static_cast<int>(Counter::Count); i++)
+    {
+        out << (i ? ", " : "") << "\"" << counterNames[i] << "\": " << counters[i];
+    }
+    out << "}";
+
+    const std::uint64_t raw = counters[static_cast<int>(Counter::BytesRaw)];
+    const std::uint64_t encoded = counters[static_cast<int>(Counter::BytesEncoded)];
+    out << ", \"rle_compression_ratio\": " << std::fixed << std::setprecision(3)
+        << (encoded ? static_cast<double>(raw) / encoded : 0.0) << "}" << std::endl;
+}
+} // namespace stats
@@ -0,0 +1,122 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+/**
+ * @brief Lightweight per-stage timers and counters for the render pipeline
+ *
+ * Instrumentation points use the STATS_* macros below. When RENDERER_STATS is not
+ * defined (CMake option ENABLE_STATS=OFF) every macro compiles to nothing, so the
+ * hot paths carry no cost. Counters are plain integers: the pipeline is single threaded.
+ */
+namespace stats
+{
+/**
+ * @brief Pipeline stages with their own wall-clock timer
+ */
+enum class Stage
+{
+    Load,          // Parsing model and texture files
+    Projection,    // Transforming vertices to screen space and binning
+    Rasterization, // Drawing primitives into the framebuffer
+    Shading,       // Texturing and lighting visible pixels
+    Encode,        // Compressing pixel data for output
+    Write,         // Writing encoded bytes to disk
+    Count
+};
+
+/**
+ * @brief Event counters accumulated across a run
+ */
+enum class Counter
+{
+    LinesDrawn,      // Calls to line() that reached the framebuffer
+    PixelsWritten,   // Pixels stored by the rasterizers
+    PixelsClipped,   // Pixels of a primitive that fell outside the framebuffer
+    BytesRaw,        // Uncompressed pixel bytes handed to the encoder
+    BytesEncoded,    // Pixel bytes produced by the encoder
+    InstancesDrawn,  // Model instances that passed culling
+    InstancesCulled, // Model instances rejected by their bounding box
+    PixelsRedrawn,   // Pixels inside dirty rectangles re-rendered incrementally
+    FragmentsTested, // Triangle samples depth-tested by the visibility pass
+    PixelsShaded,    // Visible pixels shaded by the deferred pass
+    MeshletsDrawn,   // Clusters that passed culling and were rasterized
+    MeshletsCulled,  // Clusters rejected as off-screen or back-facing
+    Count
+};
+
+struct StageTotals
+{
+    std::uint64_t calls = 0;
+    std::uint64_t nanoseconds = 0;
+};
+
+extern StageTotals stageTotals[static_cast<int>(Stage::Count)];
+extern std::uint64_t counters[static_cast<int>(Counter::Count)];
+
+inline void add(Counter counter, std::uint64_t amount)
+{
+    counters[static_cast<int>(counter)] += amount;
+}
+
+/**
+ * @brief Adds the lifetime of the enclosing scope to a stage's timer
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Stage stage) : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        StageTotals &totals = stageTotals[static_cast<int>(stage_)];
+        totals.calls++;
+        totals.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    Stage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief Whether instrumentation was compiled in
+ */
+constexpr bool enabled()
+{
+#ifdef RENDERER_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Zero all timers and counters, e.g. between runs of a resident process
+ */
+void reset();
+
+/**
+ * @brief Write the current timers and counters as a single JSON object
+ *
+ * Includes the RLE compression ratio (raw bytes / encoded bytes) derived from the counters.
+ */
+void writeJson(std::ostream &out);
+} // namespace stats
+
+#define STATS_CONCAT_INNER(a, b) a##b
+#define STATS_CONCAT(a, b) STATS_CONCAT_INNER(a, b)
+
+#ifdef RENDERER_STATS
+#define STATS_SCOPED_TIMER(stage) stats::ScopedTimer STATS_CONCAT(statsTimer_, __LINE__)(stats::Stage::stage)
+#define STATS_ADD(counter, amount) stats::add(stats::Counter::counter, (amount))
+#else
+// sizeof keeps the operand unevaluated but still counts as a use of any local it names
+#define STATS_SCOPED_TIMER(stage) ((void)0)
+#define STATS_ADD(counter, amount) ((void)sizeof(amount))
+#endif
@@ -1,9 +1,12 @@
 #include <iostream>
 #include <cstring>
+#include <algorithm>
 #include "tgaimage.h"
+#include "stats.h"
 
 // Constructor: Initialize image with width, height, and bytes per pixel
-TGAImage::TGAImage(const int w, const int h, const int bpp) : w(w), h(h), bpp(bpp), data(w*h*bpp, 0) {}
+// Sizes are computed in size_t so images past 2 GB do not overflow int arithmetic
+TGAImage::TGAImage(const int w, const int h, const int bpp) : w(w), h(h), bpp(bpp), data(static_cast<size_t>(w)*h*bpp, 0) {}
 
 // Read a TGA file from disk
 bool TGAImage::read_tga_file(const std::string filename) {
@@ -13,6 +16,14 @@ bool TGAImage::read_tga_file(const std::string filename) {
         std::cerr << "can't open file " << filename << "\n";
         return false;
     }
+    if (!read_tga(in)) return false;
+    std::cerr << w << "x" << h << "/" << bpp*8 << "\n";
+    return true;
+}
+
+// Decode a TGA image from any input stream
+bool TGAImage::read_tga(std::istream &in) {
+    STATS_SCOPED_TIMER(Load);
 
     // Read the TGA header
     TGAHeader header;
@@ -34,7 +45,7 @@ bool TGAImage::read_tga_file(const std::string filename) {
     }
 
     // Allocate memory for pixel data
-    size_t nbytes = bpp*w*h;
+    size_t nbytes = static_cast<size_t>(bpp)*w*h;
     data = std::vector<std::uint8_t>(nbytes, 0);
 
     // Read image data based on compression type
@@ -61,14 +72,12 @@ bool TGAImage::read_tga_file(const std::string filename) {
         flip_vertically();
     if (header.imagedescriptor & 0x10)
         flip_horizontally();
-
-    std::cerr << w << "x" << h << "/" << bpp*8 << "\n";
     return true;
 }
 
 // Load RLE (Run-Length Encoded) compressed data
-bool TGAImage::load_rle_data(std::ifstream &in) {
-    size_t pixelcount = w*h;
+bool TGAImage::load_rle_data(std::istream &in) {
+    size_t pixelcount = static_cast<size_t>(w)*h;
     size_t currentpixel = 0;
     size_t currentbyte  = 0;
     TGAColor colorbuffer;
@@ -121,59 +130,42 @@ bool TGAImage::load_rle_data(std::ifstream &in) {
     return true;
 }
 
-// Write image to TGA file
-bool TGAImage::write_tga_file(const std::string filename, const bool vflip, const bool rle) const {
-    // TGA file footer components
-    constexpr std::uint8_t developer_area_ref[4] = {0, 0, 0, 0};
-    constexpr std::uint8_t extension_area_ref[4] = {0, 0, 0, 0};
-    constexpr std::uint8_t footer[18] = {'T','R','U','E','V','I','S','I','O','N','-','X','F','I','L','E','.','\0'};
+// TGA file footer components
+static constexpr std::uint8_t developer_area_ref[4] = {0, 0, 0, 0};
+static constexpr std::uint8_t extension_area_ref[4] = {0, 0, 0, 0};
+static constexpr std::uint8_t footer[18] = {'T','R','U','E','V','I','S','I','O','N','-','X','F','I','L','E','.','\0'};
 
-    // Open output file
-    std::ofstream out;
-    out.open(filename, std::ios::binary);
-    if (!out.is_open()) {
-        std::cerr << "can't open file " << filename << "\n";
+// Write the TGA header for a w x h image; the header stores 16-bit dimensions
+static bool write_header(std::ostream &out, const int w, const int h, const int bpp, const bool vflip, const bool rle) {
+    if (w<=0 || h<=0 || w>TGAImage::max_dimension || h>TGAImage::max_dimension) {
+        std::cerr << "tga dimensions " << w << "x" << h << " out of range\n";
         return false;
     }
-
-    // Prepare and write header
     TGAHeader header = {};
     header.bitsperpixel = bpp<<3;
     header.width  = w;
     header.height = h;
-    header.datatypecode = (bpp==GRAYSCALE ? (rle?11:3) : (rle?10:2));
+    header.datatypecode = (bpp==TGAImage::GRAYSCALE ? (rle?11:3) : (rle?10:2));
     header.imagedescriptor = vflip ? 0x00 : 0x20; // top-left or bottom-left origin
     out.write(reinterpret_cast<const char *>(&header), sizeof(header));
-    if (!out.good()) goto err;
-
-    // Write image data
-    if (!rle) {
-        // Write uncompressed data
-        out.write(reinterpret_cast<const char *>(data.data()), w*h*bpp);
-        if (!out.good()) goto err;
-    } else if (!unload_rle_data(out)) goto err;
+    return out.good();
+}
 
-    // Write footer components
+// Write the developer/extension area references and the TGA 2.0 signature
+static bool write_footer(std::ostream &out) {
     out.write(reinterpret_cast<const char *>(developer_area_ref), sizeof(developer_area_ref));
-    if (!out.good()) goto err;
     out.write(reinterpret_cast<const char *>(extension_area_ref), sizeof(extension_area_ref));
-    if (!out.good()) goto err;
     out.write(reinterpret_cast<const char *>(footer), sizeof(footer));
-    if (!out.good()) goto err;
-    return true;
-
-err:
-    std::cerr << "can't dump the tga file\n";
-    return false;
+    return out.good();
 }
 
-// Save data with RLE compression
-bool TGAImage::unload_rle_data(std::ofstream &out) const {
+// Encode pixels from curpix onwards as RLE packets, stopping at the first packet boundary
+// once the buffer holds at least limit bytes; returns the first pixel not yet encoded
+static size_t encode_rle(const std::uint8_t *data, size_t curpix, const size_t npixels, const int bpp,
+                         std::vector<std::uint8_t> &packets, const size_t limit) {
     const std::uint8_t max_chunk_length = 128;
-    size_t npixels = w*h;
-    size_t curpix = 0;
 
-    while (curpix<npixels) {
+    while (curpix<npixels && packets.size()<limit) {
         size_t chunkstart = curpix*bpp;
         size_t curbyte = curpix*bpp;
         std::uint8_t run_length = 1;
@@ -197,19 +189,78 @@ bool TGAImage::unload_rle_data(std::ofstream &out) const {
         }
 
         curpix += run_length;
-        out.put(raw ? run_length-1 : run_length+127);
-        if (!out.good()) return false;
-        out.write(reinterpret_cast<const char *>(data.data()+chunkstart), (raw?run_length*bpp:bpp));
+        packets.push_back(raw ? run_length-1 : run_length+127);
+        packets.insert(packets.end(), data+chunkstart, data+chunkstart+(raw?run_length*bpp:bpp));
+    }
+    return curpix;
+}
+
+// Encode and write in bounded chunks: memory stays at about 64 KB whatever the image
+// size, and encoding and disk writes are still timed separately
+static bool write_rle(std::ostream &out, const std::uint8_t *data, const size_t npixels, const int bpp) {
+    const size_t chunk_bytes = 64*1024;
+    std::vector<std::uint8_t> packets;
+    packets.reserve(chunk_bytes + 1 + 128*4);
+    size_t curpix = 0;
+    while (curpix<npixels) {
+        packets.clear();
+        {
+            STATS_SCOPED_TIMER(Encode);
+            curpix = encode_rle(data, curpix, npixels, bpp, packets, chunk_bytes);
+        }
+        STATS_ADD(BytesEncoded, packets.size());
+
+        STATS_SCOPED_TIMER(Write);
+        out.write(reinterpret_cast<const char *>(packets.data()), packets.size());
         if (!out.good()) return false;
     }
+    STATS_ADD(BytesRaw, npixels*bpp);
+    return true;
+}
+
+// Write image to TGA file
+bool TGAImage::write_tga_file(const std::string filename, const bool vflip, const bool rle) const {
+    // Open output file
+    std::ofstream out;
+    out.open(filename, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "can't open file " << filename << "\n";
+        return false;
+    }
+    if (!write_tga(out, vflip, rle)) {
+        std::cerr << "can't dump the tga file\n";
+        return false;
+    }
     return true;
 }
 
+// Encode the image as a complete TGA file into any output stream
+bool TGAImage::write_tga(std::ostream &out, const bool vflip, const bool rle) const {
+    // Prepare and write header
+    if (!write_header(out, w, h, bpp, vflip, rle)) return false;
+
+    // Write image data
+    if (!rle) {
+        // Write uncompressed data
+        STATS_SCOPED_TIMER(Write);
+        out.write(reinterpret_cast<const char *>(data.data()), data.size());
+        if (!out.good()) return false;
+    } else if (!unload_rle_data(out)) return false;
+
+    // Write footer components
+    return write_footer(out);
+}
+
+// Save data with RLE compression
+bool TGAImage::unload_rle_data(std::ostream &out) const {
+    return write_rle(out, data.data(), static_cast<size_t>(w)*h, bpp);
+}
+
 // Get pixel color at specified coordinates
 TGAColor TGAImage::get(const int x, const int y) const {
     if (!data.size() || x<0 || y<0 || x>=w || y>=h) return {};
     TGAColor ret = {0, 0, 0, 0, bpp};
-    const std::uint8_t *p = data.data()+(x+y*w)*bpp;
+    const std::uint8_t *p = data.data()+(x+static_cast<size_t>(y)*w)*bpp;
     for (int i=bpp; i--; ret.bgra[i] = p[i]);
     return ret;
 }
@@ -217,7 +268,7 @@ TGAColor TGAImage::get(const int x, const int y) const {
 // Set pixel color at specified coordinates
 void TGAImage::set(int x, int y, const TGAColor &c) {
     if (!data.size() || x<0 || y<0 || x>=w || y>=h) return;
-    memcpy(data.data()+(x+y*w)*bpp, c.bgra, bpp);
+    memcpy(data.data()+(x+static_cast<size_t>(y)*w)*bpp, c.bgra, bpp);
 }
 
 // Flip image horizontally
@@ -225,7 +276,7 @@ void TGAImage::flip_horizontally() {
     for (int i=0; i<w/2; i++)
         for (int j=0; j<h; j++)
             for (int b=0; b<bpp; b++)
-                std::swap(data[(i+j*w)*bpp+b], data[(w-1-i+j*w)*bpp+b]);
+                std::swap(data[(i+static_cast<size_t>(j)*w)*bpp+b], data[(w-1-i+static_cast<size_t>(j)*w)*bpp+b]);
 }
 
 // Flip image vertically
@@ -233,7 +284,7 @@ void TGAImage::flip_vertically() {
     for (int i=0; i<w; i++)
         for (int j=0; j<h/2; j++)
             for (int b=0; b<bpp; b++)
-                std::swap(data[(i+j*w)*bpp+b], data[(i+(h-1-j)*w)*bpp+b]);
+                std::swap(data[(i+static_cast<size_t>(j)*w)*bpp+b], data[(i+static_cast<size_t>(h-1-j)*w)*bpp+b]);
 }
 
 // Get image width
@@ -246,3 +297,108 @@ int TGAImage::height() const {
     return h;
 }
 
+// Get bytes per pixel
+int TGAImage::bytes_per_pixel() const {
+    return bpp;
+}
+
+// Get raw pixel data
+const std::uint8_t *TGAImage::buffer() const {
+    return data.data();
+}
+
+std::uint8_t *TGAImage::buffer() {
+    return data.data();
+}
+
+// Reset every pixel to zero without reallocating
+void TGAImage::clear() {
+    std::fill(data.begin(), data.end(), 0);
+}
+
+// Reset the pixels of one rectangle to zero; the rectangle is clipped to the image
+void TGAImage::clear(const int x, const int y, const int rw, const int rh) {
+    const int x0 = std::max(x, 0), x1 = std::min(x+rw, w);
+    const int y0 = std::max(y, 0), y1 = std::min(y+rh, h);
+    if (x0>=x1) return;
+    for (int j=y0; j<y1; j++)
+        std::fill_n(data.begin()+(x0+static_cast<size_t>(j)*w)*bpp, static_cast<size_t>(x1-x0)*bpp, 0);
+}
+
+// Rewrite one rectangle of a file previously written by write_tga_file(filename, true, false).
+// Uncompressed rows sit at fixed offsets, so only the changed spans touch the disk.
+bool TGAImage::update_tga_file(const std::string filename, const int x, const int y, const int rw, const int rh) const {
+    std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file.is_open()) {
+        std::cerr << "can't open file " << filename << "\n";
+        return false;
+    }
+    TGAHeader header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file.good() || header.width!=w || header.height!=h || header.bitsperpixel!=(bpp<<3) ||
+        (header.datatypecode!=2 && header.datatypecode!=3) || (header.imagedescriptor & 0x30) || header.idlength) {
+        std::cerr << "tga file does not match the image layout for in-place update\n";
+        return false;
+    }
+
+    const int x0 = std::max(x, 0), x1 = std::min(x+rw, w);
+    const int y0 = std::max(y, 0), y1 = std::min(y+rh, h);
+    STATS_SCOPED_TIMER(Write);
+    for (int j=y0; j<y1 && x0<x1; j++) {
+        const size_t offset = (x0+static_cast<size_t>(j)*w)*bpp;
+        file.seekp(sizeof(header)+offset);
+        file.write(reinterpret_cast<const char *>(data.data()+offset), static_cast<size_t>(x1-x0)*bpp);
+        if (!file.good()) {
+            std::cerr << "can't update the tga file\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Open the output file and write the header; rows are appended by write_band
+TGAStreamWriter::TGAStreamWriter(const std::string filename, const int w, const int h, const int bpp, const bool rle) : w(w), h(h), bpp(bpp), rle(rle) {
+    out.open(filename, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "can't open file " << filename << "\n";
+        return;
+    }
+    ok = write_header(out, w, h, bpp, true, rle);
+    if (!ok) std::cerr << "can't dump the tga file\n";
+}
+
+bool TGAStreamWriter::is_open() const {
+    return ok;
+}
+
+// Append the first `rows` rows of band; bands must arrive bottom row first
+bool TGAStreamWriter::write_band(const TGAImage &band, const int rows) {
+    if (!ok) return false;
+    if (band.width()!=w || band.bytes_per_pixel()!=bpp || rows<0 || rows>band.height() || rows_written+rows>h) {
+        std::cerr << "band does not fit the tga stream\n";
+        return ok = false;
+    }
+    const size_t npixels = static_cast<size_t>(w)*rows;
+    if (rle) ok = write_rle(out, band.buffer(), npixels, bpp);
+    else {
+        STATS_SCOPED_TIMER(Write);
+        out.write(reinterpret_cast<const char *>(band.buffer()), npixels*bpp);
+        ok = out.good();
+    }
+    rows_written += rows;
+    if (!ok) std::cerr << "can't dump the tga file\n";
+    return ok;
+}
+
+// Write the footer once every row has been streamed
+bool TGAStreamWriter::close() {
+    if (!ok) return false;
+    if (rows_written!=h) {
+        std::cerr << "tga stream closed after " << rows_written << " of " << h << " rows\n";
+        return ok = false;
+    }
+    ok = write_footer(out);
+    out.close();
+    if (!ok) std::cerr << "can't dump the tga file\n";
+    return ok;
+}
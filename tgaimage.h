@@ -1,6 +1,7 @@
 #pragma once
 #include <cstdint>
 #include <fstream>
+#include <string>
 #include <vector>
 
 // TGA (Truevision Targa) file format header structure
@@ -39,12 +40,17 @@ struct TGAImage {
         RGBA=4        // 32-bit RGBA
     };
 
+    static constexpr int max_dimension = 0xFFFF;  // Largest width or height a TGA header can store
+
     TGAImage() = default;  // Default constructor
     TGAImage(const int w, const int h, const int bpp); // Constructor with dimensions and bits per pixel
 
     // File operations
     bool  read_tga_file(const std::string filename);  // Read TGA file from disk
     bool write_tga_file(const std::string filename, const bool vflip=true, const bool rle=true) const; // Write TGA file to disk
+    bool  read_tga(std::istream &in);  // Decode TGA data from a stream
+    bool write_tga(std::ostream &out, const bool vflip=true, const bool rle=true) const; // Encode TGA data to a stream
+    bool update_tga_file(const std::string filename, const int x, const int y, const int rw, const int rh) const; // Patch one rectangle of an uncompressed file
 
     // Image manipulation
     void flip_horizontally();  // Flip image horizontally
@@ -55,11 +61,16 @@ struct TGAImage {
     // Image properties
     int width()  const;  // Get image width
     int height() const;  // Get image height
+    int bytes_per_pixel() const;            // Get bytes per pixel
+    const std::uint8_t *buffer() const;     // Raw pixel rows, bottom row first
+    std::uint8_t *buffer();                 // Writable raw pixel rows, for blending in place
+    void clear();                           // Reset all pixels to zero
+    void clear(const int x, const int y, const int rw, const int rh); // Reset one rectangle to zero
 
 private:
     // Private helper methods for RLE (Run-Length Encoding) compression
-    bool   load_rle_data(std::ifstream &in);    // Load RLE compressed data
-    bool unload_rle_data(std::ofstream &out) const; // Save data with RLE compression
+    bool   load_rle_data(std::istream &in);    // Load RLE compressed data
+    bool unload_rle_data(std::ostream &out) const; // Save data with RLE compression
 
     // Image data storage
     int w = 0, h = 0;  // Width and height
@@ -67,3 +78,21 @@ private:
     std::vector<std::uint8_t> data = {};  // Raw pixel data
 };
 
+// Writes a TGA file band by band so the full image never has to be in memory.
+// Bands are appended bottom row first, matching the layout of TGAImage rows.
+class TGAStreamWriter {
+public:
+    TGAStreamWriter(const std::string filename, const int w, const int h, const int bpp, const bool rle=true);
+
+    bool is_open() const;                                // Header written and no error so far
+    bool write_band(const TGAImage &band, const int rows); // Append the first `rows` rows of band
+    bool close();                                        // Write footer; fails if rows are missing
+
+private:
+    std::ofstream out;
+    int w = 0, h = 0;        // Full image dimensions
+    std::uint8_t bpp = 0;    // Bytes per pixel
+    bool rle = true;         // Whether bands are RLE compressed
+    bool ok = false;         // Cleared on the first failure
+    int rows_written = 0;    // Rows streamed so far
+};